@@ -0,0 +1,21 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#pragma once
+
+#include "grape/ipc/session.h"
+
+namespace grape::ego_clock::bench {
+
+//-------------------------------------------------------------------------------------------------
+/// Initialise IPC for the clocks under benchmark, once per process
+inline void initIpc() {
+  static const auto is_ipc_init = [] {
+    ipc::init({});
+    return true;
+  }();
+  (void)is_ipc_init;
+}
+
+}  // namespace grape::ego_clock::bench
@@ -2,20 +2,30 @@
 // Copyright (C) 2025 GRAPE Contributors
 //=================================================================================================
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <print>
 #include <thread>
+#include <vector>
+
+#include <sys/resource.h>
 
 #include <benchmark/benchmark.h>
 
+#include "bench_ipc.h"
+#include "grape/ego_clock.h"
 #include "grape/ego_clock2.h"
 #include "grape/ego_clock2_driver.h"
+#include "grape/ego_clock_driver.h"
 #include "grape/exception.h"
-#include "grape/ipc/session.h"
 #include "grape/wall_clock.h"
 
 namespace {
 
+using grape::ego_clock::bench::initIpc;
+
 //-------------------------------------------------------------------------------------------------
 void masterClock(const std::stop_token& st, const std::string& clock_name) {
   try {
@@ -40,11 +50,7 @@ void masterClock(const std::stop_token& st, const std::string& clock_name) {
 //-------------------------------------------------------------------------------------------------
 // Benchmark EgoClock2::now()
 void bmEgoClock2Now(benchmark::State& state) {
-  static auto is_ipc_init = false;
-  if (not is_ipc_init) {
-    grape::ipc::init({});
-    is_ipc_init = true;
-  }
+  initIpc();
 
   static auto count = 0;
   const auto clock_name = "bm_clock_" + std::to_string(count++);
@@ -67,6 +73,197 @@ void bmEgoClock2Now(benchmark::State& state) {
 }
 BENCHMARK(bmEgoClock2Now)->Unit(benchmark::kNanosecond);
 
+//-------------------------------------------------------------------------------------------------
+// Driver for EgoClock2 that ticks every millisecond, at the same rate as the wall clock
+void fastDriverClock(const std::stop_token& st, const std::string& clock_name) {
+  try {
+    static constexpr auto TICK_PERIOD = std::chrono::milliseconds(1);
+    const auto config =
+        grape::EgoClock2Driver::Config{ .clock_name = clock_name, .wake_resolution = TICK_PERIOD };
+    auto driver = grape::EgoClock2Driver(config);
+    auto ego_time = grape::EgoClock2::TimePoint{};
+    while (not st.stop_requested()) {
+      const auto wall_time = grape::WallClock::now();
+      ego_time += TICK_PERIOD;
+      driver.tick(ego_time);
+      std::this_thread::sleep_until(wall_time + TICK_PERIOD);
+    }
+  } catch (...) {
+    grape::Exception::print();
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+// @return Number of context switches of the calling thread so far
+auto threadContextSwitches() -> std::int64_t {
+  auto usage = rusage{};
+  getrusage(RUSAGE_THREAD, &usage);
+  return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Benchmark EgoClock2::sleepUntil() with state.range(0) threads sleeping until deadlines spread
+// over the next 50 ms, while the driver ticks at 1 kHz. Reports how late sleepers wake (in ego
+// time, so including up to one tick of quantisation) and how often each is switched in while
+// asleep. Ideally that is once, at its deadline, however many others are sleeping.
+void bmEgoClock2SleepUntil(benchmark::State& state) {
+  static constexpr auto SPREAD_TICKS = 50;
+  static constexpr auto MIN_SLEEP = std::chrono::milliseconds(10);
+  const auto num_sleepers = static_cast<int>(state.range(0));
+
+  static auto count = 0;
+  const auto clock_name = "/bm_sleep_clock_" + std::to_string(count++);
+  auto driver = std::jthread(fastDriverClock, clock_name);
+  static constexpr auto DRIVER_WAIT_TIME = std::chrono::seconds(10);
+  auto ego_clock = grape::EgoClock2::create(clock_name, DRIVER_WAIT_TIME);
+  if (not ego_clock) {
+    state.SkipWithError("No driver clock");
+    return;
+  }
+
+  auto total_latency_ns = std::atomic<std::int64_t>{ 0 };
+  auto max_latency_ns = std::atomic<std::int64_t>{ 0 };
+  auto total_switches = std::atomic<std::int64_t>{ 0 };
+  for (auto unused : state) {
+    (void)unused;
+    auto sleepers = std::vector<std::jthread>{};
+    for (auto i = 0; i < num_sleepers; ++i) {
+      sleepers.emplace_back([&, i] {
+        const auto deadline =
+            ego_clock->now() + MIN_SLEEP + std::chrono::milliseconds(i % SPREAD_TICKS);
+        const auto switches_before = threadContextSwitches();
+        ego_clock->sleepUntil(deadline);
+        const auto latency = grape::EgoClock2::toNanos(ego_clock->now()) -
+                             grape::EgoClock2::toNanos(deadline);
+        total_switches += threadContextSwitches() - switches_before;
+        total_latency_ns += latency;
+        auto max = max_latency_ns.load();
+        while (latency > max and not max_latency_ns.compare_exchange_weak(max, latency)) {
+        }
+      });
+    }
+    sleepers.clear();
+  }
+  driver.request_stop();
+
+  const auto num_wakes = static_cast<double>(state.iterations() * num_sleepers);
+  state.SetItemsProcessed(state.iterations() * num_sleepers);
+  state.counters["latency_us"] = static_cast<double>(total_latency_ns) / num_wakes / 1e3;
+  state.counters["max_latency_us"] = static_cast<double>(max_latency_ns) / 1e3;
+  state.counters["switches_per_sleep"] = static_cast<double>(total_switches) / num_wakes;
+}
+BENCHMARK(bmEgoClock2SleepUntil)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(64)
+    ->Arg(200)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+//-------------------------------------------------------------------------------------------------
+// Master for EgoClock that ticks and broadcasts a new clock transform at 1 kHz
+void fastMasterClock(const std::stop_token& st, const std::string& clock_name) {
+  try {
+    static constexpr auto TICK_PERIOD = std::chrono::milliseconds(1);
+    const auto config = grape::EgoClockDriver::Config{ .clock_name = clock_name,
+                                                       .broadcast_interval = TICK_PERIOD,
+                                                       .calibration_window = 2U };
+    auto driver = grape::EgoClockDriver(config);
+    auto ego_time = grape::EgoClock::TimePoint{};
+    while (not st.stop_requested()) {
+      const auto wall_time = grape::WallClock::now();
+      driver.tick(ego_time, wall_time);
+      std::this_thread::sleep_until(wall_time + TICK_PERIOD);
+      ego_time += TICK_PERIOD;
+    }
+  } catch (...) {
+    grape::Exception::print();
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Benchmark EgoClock::now() from many threads at once, while the master updates the transform at
+// 1 kHz. Readers of the clock transform must not block each other or the receiver. Reports the
+// slowest single call seen by each thread (averaged over threads) as 'max_ns'.
+void bmEgoClockNowContended(benchmark::State& state) {
+  static auto master = std::jthread{};
+  static auto ego_clock = std::unique_ptr<grape::EgoClock>{};
+
+  if (state.thread_index() == 0) {
+    initIpc();
+    static auto count = 0;
+    const auto clock_name = "bm_fast_clock_" + std::to_string(count++);
+    master = std::jthread(fastMasterClock, clock_name);
+    static constexpr auto MASTER_WAIT_TIME = std::chrono::seconds(10);
+    auto maybe_clock = grape::EgoClock::create(clock_name, MASTER_WAIT_TIME);
+    if (maybe_clock) {
+      ego_clock = std::make_unique<grape::EgoClock>(std::move(*maybe_clock));
+    }
+  }
+
+  auto max_call_time = std::chrono::nanoseconds{ 0 };
+  for (auto unused : state) {
+    (void)unused;
+    if (ego_clock == nullptr) {
+      state.SkipWithError("No master clock");
+      break;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    auto time_point = ego_clock->now();
+    const auto call_time = std::chrono::steady_clock::now() - start;
+    benchmark::DoNotOptimize(time_point);
+    max_call_time = std::max(max_call_time, call_time);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["max_ns"] = benchmark::Counter(static_cast<double>(max_call_time.count()),
+                                                benchmark::Counter::kAvgThreads);
+  if (state.thread_index() == 0) {
+    ego_clock.reset();
+    master = std::jthread{};
+  }
+}
+BENCHMARK(bmEgoClockNowContended)
+    ->ThreadRange(1, 32)
+    ->UseRealTime()
+    ->Unit(benchmark::kNanosecond);
+
+//-------------------------------------------------------------------------------------------------
+// Benchmark EgoClock::now() with the time source given by state.range(0) (EgoClock::TimeSource),
+// while the master updates the transform at 1 kHz
+void bmEgoClockNow(benchmark::State& state) {
+  initIpc();
+
+  static auto count = 0;
+  const auto clock_name = "bm_source_clock_" + std::to_string(count++);
+  auto master = std::jthread(fastMasterClock, clock_name);
+  static constexpr auto MASTER_WAIT_TIME = std::chrono::seconds(10);
+  const auto time_source = static_cast<grape::EgoClock::TimeSource>(state.range(0));
+  auto ego_clock = grape::EgoClock::create(clock_name, MASTER_WAIT_TIME,
+                                           grape::EgoClock::DEFAULT_SLEW_WINDOW, time_source);
+  if (not ego_clock) {
+    state.SkipWithError("No master clock");
+    return;
+  }
+  if (ego_clock->timeSource() != time_source) {
+    state.SkipWithError("TSC not usable on this machine");
+    return;
+  }
+
+  for (auto unused : state) {
+    (void)unused;
+    auto time_point = ego_clock->now();
+    benchmark::DoNotOptimize(time_point);
+  }
+  master.request_stop();
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bmEgoClockNow)
+    ->ArgName("tsc")
+    ->Arg(static_cast<int>(grape::EgoClock::TimeSource::WallClock))
+    ->Arg(static_cast<int>(grape::EgoClock::TimeSource::Tsc))
+    ->Unit(benchmark::kNanosecond);
+
 //-------------------------------------------------------------------------------------------------
 // Benchmark WallClock::now() for comparison
 void bmWallClockNow(benchmark::State& state) {
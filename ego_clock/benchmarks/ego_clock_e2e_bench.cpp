@@ -0,0 +1,296 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+// End-to-end benchmarks for EgoClock against a simulated master clock in the same process.
+//
+// The master's ego clock runs 'drift_ppm' faster than the wall clock, and it ticks 'tick_hz' times
+// per second, reporting each tick with Gaussian timestamp noise of 'jitter_us' (standard
+// deviation). Its driver broadcasts a fit every 'bcast_ms', over the last 'window' ticks. Each
+// benchmark reports the 50th, 99th and 99.9th percentiles of what it measures, to help choose
+// EgoClockDriver::Config::broadcast_interval and calibration_window for a given master.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_ipc.h"
+#include "grape/ego_clock.h"
+#include "grape/ego_clock_driver.h"
+#include "grape/exception.h"
+#include "grape/wall_clock.h"
+
+namespace {
+
+using grape::ego_clock::bench::initIpc;
+
+//=================================================================================================
+// Master clock with known drift and timestamp noise, driving an EgoClockDriver from a thread
+class SimulatedMaster {
+public:
+  struct Config {
+    double tick_hz{ 100. };                //!< Tick rate of the master
+    double drift_ppm{ 0. };                //!< How much faster the ego clock runs than wall clock
+    double jitter_us{ 0. };                //!< Standard deviation of noise on tick timestamps
+    std::int64_t broadcast_ms{ 20 };       //!< EgoClockDriver::Config::broadcast_interval
+    std::size_t calibration_window{ 2U };  //!< EgoClockDriver::Config::calibration_window
+  };
+
+  /// Configuration from benchmark arguments: tick_hz, drift_ppm, jitter_us, bcast_ms, window
+  static auto configFrom(const benchmark::State& state) -> Config;
+
+  SimulatedMaster(const Config& config, std::string clock_name);
+
+  /// @return The ego time the master's clock shows at a wall clock time
+  [[nodiscard]] auto trueEgoTime(const grape::WallClock::TimePoint& wall_time) const
+      -> grape::EgoClock::TimePoint;
+
+  /// @return Wall clock time of the master's tick that broadcast the fit with a sequence number,
+  /// or nothing if it hasn't been broadcast yet
+  [[nodiscard]] auto broadcastTime(std::uint64_t sequence) const
+      -> std::optional<grape::WallClock::TimePoint>;
+
+private:
+  void run(const std::stop_token& st) const;
+
+  Config config_;
+  std::string clock_name_;
+  grape::WallClock::TimePoint start_;
+  mutable std::mutex broadcasts_mutex_;
+  mutable std::vector<grape::WallClock::TimePoint> broadcast_times_;  //!< by sequence number - 1
+  std::jthread thread_;
+};
+
+//-------------------------------------------------------------------------------------------------
+auto SimulatedMaster::configFrom(const benchmark::State& state) -> Config {
+  return { .tick_hz = static_cast<double>(state.range(0)),
+           .drift_ppm = static_cast<double>(state.range(1)),
+           .jitter_us = static_cast<double>(state.range(2)),
+           .broadcast_ms = state.range(3),
+           .calibration_window = static_cast<std::size_t>(state.range(4)) };
+}
+
+//-------------------------------------------------------------------------------------------------
+SimulatedMaster::SimulatedMaster(const Config& config, std::string clock_name)
+  : config_(config)
+  , clock_name_(std::move(clock_name))
+  , start_(grape::WallClock::now())
+  , thread_([this](const std::stop_token& st) { run(st); }) {
+}
+
+//-------------------------------------------------------------------------------------------------
+auto SimulatedMaster::trueEgoTime(const grape::WallClock::TimePoint& wall_time) const
+    -> grape::EgoClock::TimePoint {
+  const auto elapsed = static_cast<double>(grape::WallClock::toNanos(wall_time) -
+                                           grape::WallClock::toNanos(start_));
+  return grape::EgoClock::fromNanos(
+      static_cast<std::int64_t>(elapsed * (1. + (config_.drift_ppm * 1e-6))));
+}
+
+//-------------------------------------------------------------------------------------------------
+auto SimulatedMaster::broadcastTime(std::uint64_t sequence) const
+    -> std::optional<grape::WallClock::TimePoint> {
+  auto lock = std::lock_guard(broadcasts_mutex_);
+  if ((sequence == 0U) or (sequence > broadcast_times_.size())) {
+    return std::nullopt;
+  }
+  return broadcast_times_.at(sequence - 1U);
+}
+
+//-------------------------------------------------------------------------------------------------
+void SimulatedMaster::run(const std::stop_token& st) const {
+  try {
+    const auto config =
+        grape::EgoClockDriver::Config{ .clock_name = clock_name_,
+                                       .broadcast_interval = std::chrono::milliseconds(
+                                           config_.broadcast_ms),
+                                       .calibration_window = config_.calibration_window };
+    auto driver = grape::EgoClockDriver(config);
+    auto gen = std::mt19937{ std::random_device{}() };
+    auto noise = std::normal_distribution<>{ 0., config_.jitter_us * 1e3 };
+    const auto period = std::chrono::duration_cast<grape::WallClock::Duration>(
+        std::chrono::duration<double>(1. / config_.tick_hz));
+
+    auto next_tick = start_;
+    while (not st.stop_requested()) {
+      std::this_thread::sleep_until(next_tick);
+      next_tick += period;
+      const auto wall_time = grape::WallClock::now();
+      const auto reported_wall_time =
+          wall_time + grape::WallClock::Duration(static_cast<std::int64_t>(noise(gen)));
+      driver.tick(trueEgoTime(wall_time), reported_wall_time);
+      if (driver.sequence() != 0U) {
+        auto lock = std::lock_guard(broadcasts_mutex_);
+        broadcast_times_.resize(driver.sequence(), wall_time);
+      }
+    }
+  } catch (...) {
+    grape::Exception::print();
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Start a simulated master configured from the benchmark arguments, and a clock following it
+auto startClock(const benchmark::State& state)
+    -> std::pair<std::unique_ptr<SimulatedMaster>, std::optional<grape::EgoClock>> {
+  initIpc();
+  static auto count = 0;
+  const auto clock_name = "e2e_clock_" + std::to_string(count++);
+  auto master = std::make_unique<SimulatedMaster>(SimulatedMaster::configFrom(state), clock_name);
+  static constexpr auto MASTER_WAIT_TIME = std::chrono::seconds(10);
+  auto clock = grape::EgoClock::create(clock_name, MASTER_WAIT_TIME);
+  return { std::move(master), std::move(clock) };
+}
+
+//-------------------------------------------------------------------------------------------------
+// Report the 50th, 99th and 99.9th percentile of samples as counters 'name_p50' etc.
+void reportPercentiles(benchmark::State& state, const std::string& name,
+                       std::vector<double>& samples) {
+  if (samples.empty()) {
+    return;
+  }
+  std::ranges::sort(samples);
+  const auto percentile = [&samples](double p) {
+    const auto rank = static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1U));
+    return samples.at(rank);
+  };
+  state.counters[name + "_p50"] = percentile(0.5);
+  state.counters[name + "_p99"] = percentile(0.99);
+  state.counters[name + "_p999"] = percentile(0.999);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Cost of EgoClock::now() in ns, which reads the latest fit received over IPC
+void bmNowLatency(benchmark::State& state) {
+  auto [master, clock] = startClock(state);
+  if (not clock) {
+    state.SkipWithError("No master clock");
+    return;
+  }
+  auto samples = std::vector<double>{};
+  for (auto unused : state) {
+    (void)unused;
+    const auto start = std::chrono::steady_clock::now();
+    auto time_point = clock->now();
+    const auto end = std::chrono::steady_clock::now();
+    benchmark::DoNotOptimize(time_point);
+    samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+  }
+  state.SetItemsProcessed(state.iterations());
+  reportPercentiles(state, "now_ns", samples);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Time in µs from the master's tick that triggers a broadcast until the clock is using the new fit.
+// Each iteration waits for one broadcast, and measures from the tick that broadcast the fit seen
+void bmTickToObserve(benchmark::State& state) {
+  auto [master, clock] = startClock(state);
+  if (not clock) {
+    state.SkipWithError("No master clock");
+    return;
+  }
+  auto samples = std::vector<double>{};
+  auto sequence = clock->nowChecked().sequence;
+  for (auto unused : state) {
+    (void)unused;
+    auto seen = clock->nowChecked().sequence;
+    while (seen == sequence) {
+      std::this_thread::yield();
+      seen = clock->nowChecked().sequence;
+    }
+    const auto observed = grape::WallClock::now();
+    sequence = seen;
+    // The master records the tick once its driver returns, which may be after the clock saw it
+    auto broadcast_time = master->broadcastTime(sequence);
+    while (not broadcast_time) {
+      std::this_thread::yield();
+      broadcast_time = master->broadcastTime(sequence);
+    }
+    const auto latency = observed - *broadcast_time;
+    samples.push_back(std::chrono::duration<double, std::micro>(latency).count());
+  }
+  reportPercentiles(state, "observe_us", samples);
+}
+
+//-------------------------------------------------------------------------------------------------
+// How late EgoClock::sleepUntil() returns, in µs of ego time, for deadlines 1 to 10 ms ahead
+void bmSleepOvershoot(benchmark::State& state) {
+  auto [master, clock] = startClock(state);
+  if (not clock) {
+    state.SkipWithError("No master clock");
+    return;
+  }
+  auto gen = std::mt19937{ std::random_device{}() };
+  auto delay_us = std::uniform_int_distribution<std::int64_t>{ 1'000, 10'000 };
+  auto samples = std::vector<double>{};
+  for (auto unused : state) {
+    (void)unused;
+    const auto deadline = clock->now() + std::chrono::microseconds(delay_us(gen));
+    clock->sleepUntil(deadline);
+    const auto overshoot = clock->now() - deadline;
+    samples.push_back(std::chrono::duration<double, std::micro>(overshoot).count());
+  }
+  reportPercentiles(state, "overshoot_us", samples);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Absolute error in µs of EgoClock::now() against the master's true ego time, sampled every 5 ms
+// after the calibration window has filled
+void bmFitError(benchmark::State& state) {
+  auto [master, clock] = startClock(state);
+  if (not clock) {
+    state.SkipWithError("No master clock");
+    return;
+  }
+  const auto config = SimulatedMaster::configFrom(state);
+  const auto warm_up = std::chrono::duration<double>(
+      static_cast<double>(config.calibration_window + 1U) / config.tick_hz);
+  std::this_thread::sleep_for(warm_up);
+
+  static constexpr auto SAMPLE_PERIOD = std::chrono::milliseconds(5);
+  auto samples = std::vector<double>{};
+  for (auto unused : state) {
+    (void)unused;
+    std::this_thread::sleep_for(SAMPLE_PERIOD);
+    const auto ego_time = clock->now();
+    const auto true_ego_time = master->trueEgoTime(grape::WallClock::now());
+    const auto error = std::chrono::duration<double, std::micro>(ego_time - true_ego_time);
+    samples.push_back(std::abs(error.count()));
+  }
+  reportPercentiles(state, "error_us", samples);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Default master: 100 Hz, 50 ppm drift, 100 µs timestamp noise, 20 ms broadcasts, 10 tick window
+void defaultMaster(benchmark::internal::Benchmark* bm) {
+  bm->ArgNames({ "tick_hz", "drift_ppm", "jitter_us", "bcast_ms", "window" });
+  bm->Args({ 100, 50, 100, 20, 10 });
+}
+
+//-------------------------------------------------------------------------------------------------
+// Fit accuracy over the parameters to be tuned, for a few kinds of master
+void fitParameters(benchmark::internal::Benchmark* bm) {
+  bm->ArgNames({ "tick_hz", "drift_ppm", "jitter_us", "bcast_ms", "window" });
+  bm->ArgsProduct({ { 100 }, { 50 }, { 0, 100, 1000 }, { 20, 100 }, { 2, 10, 50 } });
+  bm->Args({ 1000, 50, 100, 20, 100 });
+  bm->Args({ 100, 500, 100, 20, 10 });
+}
+
+BENCHMARK(bmNowLatency)->Apply(defaultMaster)->Unit(benchmark::kNanosecond);
+BENCHMARK(bmTickToObserve)->Apply(defaultMaster)->Iterations(200)->Unit(benchmark::kMillisecond);
+BENCHMARK(bmSleepOvershoot)->Apply(defaultMaster)->Iterations(500)->Unit(benchmark::kMillisecond);
+BENCHMARK(bmFitError)->Apply(fitParameters)->Iterations(400)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -36,17 +36,70 @@ auto createSampleData() -> std::array<DataPoint, NumPoints> {
   return data;
 }
 
+//-------------------------------------------------------------------------------------------------
+// Sample data with a spike outlier every SPIKE_INTERVAL samples, e.g. late ticks from the master
+template <std::size_t NumPoints>
+auto createSpikySampleData() -> std::array<DataPoint, NumPoints> {
+  constexpr auto SPIKE_INTERVAL = 16UZ;
+  constexpr double SPIKE = 50.0;
+
+  auto data = createSampleData<NumPoints>();
+  for (auto i = 0UZ; i < NumPoints; i += SPIKE_INTERVAL) {
+    data.at(i).y += SPIKE;
+  }
+  return data;
+}
+
 //-------------------------------------------------------------------------------------------------
 // Benchmark for LineFitter::fit() with different sizes of data
-template <std::size_t NumSamples>
+template <std::size_t NumSamples, LineFitter::Mode FitMode>
 void bmLineFitterFit(benchmark::State& state) {
-  auto fitter = LineFitter(NumSamples);
+  auto fitter = LineFitter(NumSamples, FitMode);
+  const auto sample_data = createSampleData<NumSamples>();
+
+  for (const auto& point : sample_data) {
+    fitter.add(point);
+  }
+
+  for (auto unused : state) {
+    (void)unused;
+    auto result = fitter.fit();
+    benchmark::DoNotOptimize(result);
+    benchmark::ClobberMemory();
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Benchmark for LineFitter::add() followed by fit(), as done on every tick by the clock driver
+template <std::size_t NumSamples, LineFitter::Mode FitMode>
+void bmLineFitterAddFit(benchmark::State& state) {
+  auto fitter = LineFitter(NumSamples, FitMode);
   const auto sample_data = createSampleData<NumSamples>();
 
   for (const auto& point : sample_data) {
     fitter.add(point);
   }
 
+  auto index = 0UZ;
+  for (auto unused : state) {
+    (void)unused;
+    fitter.add(sample_data.at(index));
+    index = (index + 1) % NumSamples;
+    auto result = fitter.fit();
+    benchmark::DoNotOptimize(result);
+    benchmark::ClobberMemory();
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Benchmark for LineFitter::fit() on data with outliers, which takes robust fits more iterations
+template <std::size_t NumSamples, LineFitter::Mode FitMode>
+void bmLineFitterFitSpiky(benchmark::State& state) {
+  auto fitter = LineFitter(NumSamples, FitMode);
+  for (const auto& point : createSpikySampleData<NumSamples>()) {
+    fitter.add(point);
+  }
+
   for (auto unused : state) {
     (void)unused;
     auto result = fitter.fit();
@@ -55,13 +108,43 @@ void bmLineFitterFit(benchmark::State& state) {
   }
 }
 
-BENCHMARK_TEMPLATE(bmLineFitterFit, 16);
-BENCHMARK_TEMPLATE(bmLineFitterFit, 32);
-BENCHMARK_TEMPLATE(bmLineFitterFit, 64);
-BENCHMARK_TEMPLATE(bmLineFitterFit, 128);
-BENCHMARK_TEMPLATE(bmLineFitterFit, 256);
-BENCHMARK_TEMPLATE(bmLineFitterFit, 512);
-BENCHMARK_TEMPLATE(bmLineFitterFit, 1024);
+using Mode = LineFitter::Mode;
+
+BENCHMARK_TEMPLATE(bmLineFitterFit, 16, Mode::Batch);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 32, Mode::Batch);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 64, Mode::Batch);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 128, Mode::Batch);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 256, Mode::Batch);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 512, Mode::Batch);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 1024, Mode::Batch);
+
+BENCHMARK_TEMPLATE(bmLineFitterFit, 16, Mode::Incremental);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 32, Mode::Incremental);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 64, Mode::Incremental);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 128, Mode::Incremental);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 256, Mode::Incremental);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 512, Mode::Incremental);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 1024, Mode::Incremental);
+
+BENCHMARK_TEMPLATE(bmLineFitterFit, 16, Mode::Robust);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 32, Mode::Robust);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 64, Mode::Robust);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 128, Mode::Robust);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 256, Mode::Robust);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 512, Mode::Robust);
+BENCHMARK_TEMPLATE(bmLineFitterFit, 1024, Mode::Robust);
+
+BENCHMARK_TEMPLATE(bmLineFitterFitSpiky, 64, Mode::Batch);
+BENCHMARK_TEMPLATE(bmLineFitterFitSpiky, 64, Mode::Robust);
+BENCHMARK_TEMPLATE(bmLineFitterFitSpiky, 1024, Mode::Batch);
+BENCHMARK_TEMPLATE(bmLineFitterFitSpiky, 1024, Mode::Robust);
+
+BENCHMARK_TEMPLATE(bmLineFitterAddFit, 16, Mode::Batch);
+BENCHMARK_TEMPLATE(bmLineFitterAddFit, 1024, Mode::Batch);
+BENCHMARK_TEMPLATE(bmLineFitterAddFit, 16, Mode::Incremental);
+BENCHMARK_TEMPLATE(bmLineFitterAddFit, 1024, Mode::Incremental);
+BENCHMARK_TEMPLATE(bmLineFitterAddFit, 16, Mode::Robust);
+BENCHMARK_TEMPLATE(bmLineFitterAddFit, 1024, Mode::Robust);
 
 }  // namespace
 
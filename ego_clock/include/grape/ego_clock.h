@@ -5,8 +5,11 @@
 #pragma once
 
 #include <chrono>
+#include <cinttypes>
 #include <format>
+#include <memory>
 #include <optional>
+#include <string>
 
 namespace grape {
 
@@ -27,17 +30,55 @@ struct EgoClock {
   using TimePoint = std::chrono::time_point<EgoClock, Duration>;
   static constexpr bool IS_STEADY = false;
 
+  /// A timestamp, with how far it can be trusted
+  struct CheckedTime {
+    EgoClock::TimePoint time;        //!< Current timestamp, as returned by now()
+    EgoClock::Duration staleness;    //!< Time since the clock fit expired. Zero while it is valid
+    EgoClock::Duration uncertainty;  //!< Error bound. RMS error of the clock fit, growing from
+                                     //!< the time of the fit at the worst expected drift between
+                                     //!< clocks
+    std::uint64_t sequence{ 0U };    //!< Sequence number of the clock fit used
+
+    [[nodiscard]] auto isStale() const -> bool {
+      return staleness > EgoClock::Duration::zero();
+    }
+  };
+
+  /// What now() reads to extrapolate from the latest clock fit
+  enum class TimeSource : std::uint8_t {
+    WallClock,  //!< WallClock::now()
+    Tsc         //!< CPU time stamp counter, calibrated against the wall clock. Cheaper to read
+  };
+
+  /// Default for the slew_window parameter of create()
+  static constexpr auto DEFAULT_SLEW_WINDOW = std::chrono::milliseconds(100);
+
   /// Wait for master (driver) and initialise clock
   /// @param clock_name Unique identifier for clock source
   /// @param timeout How long to wait for
+  /// @param slew_window Shortest time over which to catch up with a new clock fit from the master,
+  /// rather than stepping to it. Longer if needed to keep time monotonic
+  /// @param time_source Time source for now(). TimeSource::Tsc falls back to the wall clock where
+  /// the kernel doesn't trust the TSC (see timeSource()), and takes 10 ms longer to create
   /// @return An initialised clock, or nothing if timed out waiting for master clock signal
   [[nodiscard]] static auto create(const std::string& clock_name,
-                                   const std::chrono::milliseconds& timeout)
+                                   const std::chrono::milliseconds& timeout,
+                                   const std::chrono::milliseconds& slew_window =
+                                       DEFAULT_SLEW_WINDOW,
+                                   TimeSource time_source = TimeSource::WallClock)
       -> std::optional<EgoClock>;
 
-  /// @return Current timestamp
+  /// @return Time source in use by now()
+  [[nodiscard]] auto timeSource() const -> TimeSource;
+
+  /// @return Current timestamp. Never earlier than one returned before to the same thread
   [[nodiscard]] auto now() const noexcept -> EgoClock::TimePoint;
 
+  /// Same as now(), but also reports whether updates from the master clock have stopped arriving,
+  /// and how far off the timestamp may then be. Doesn't involve any communication.
+  /// @return Current timestamp with staleness and uncertainty
+  [[nodiscard]] auto nowChecked() const noexcept -> CheckedTime;
+
   /// sleep until a given time point
   void sleepUntil(const EgoClock::TimePoint& tp) const;
 
@@ -63,7 +104,8 @@ struct EgoClock {
   auto operator=(EgoClock&&) = delete;
 
 private:
-  explicit EgoClock(const std::string& system_name);
+  EgoClock(const std::string& system_name, const std::chrono::milliseconds& slew_window,
+           TimeSource time_source);
   std::unique_ptr<ego_clock::ClockDataReceiver> rx_{ nullptr };
 };
 
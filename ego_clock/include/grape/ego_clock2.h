@@ -25,14 +25,22 @@ struct EgoClock2 {
   static constexpr bool IS_STEADY = false;
 
   /// Wait for driver and initialise clock
-  /// @param clock_name Shared memory name for the clock source (must start with '/')
+  /// @param clock_name Shared memory name for the clock source (must start with '/'), or name of
+  /// the clock in the registry
   /// @param timeout How long to wait for the first clock tick
+  /// @param registry_name Shared memory name of the registry the driver uses (see
+  /// EgoClock2Driver::Config::registry_name), or empty if it has its own segment. The clock stays
+  /// with the registry slot its driver had. Once the driver releases it and another clock claims
+  /// it, now() stays at the last tick seen and sleepUntil() throws, until a driver of the same name
+  /// claims it again
   /// @return An initialised clock, or nothing if timed out waiting for driver
   [[nodiscard]] static auto create(const std::string& clock_name,
-                                   const std::chrono::milliseconds& timeout)
+                                   const std::chrono::milliseconds& timeout,
+                                   const std::string& registry_name = {})
       -> std::optional<EgoClock2>;
 
-  /// @return Most recently posted clock value
+  /// @return Current time, interpolated from the most recently posted tick using the driver's
+  /// estimate of the tick rate. Never more than one tick period ahead of the last posted tick
   [[nodiscard]] auto now() const noexcept -> EgoClock2::TimePoint;
 
   /// Sleep until a given ego clock time point
@@ -20,6 +20,21 @@ class EgoClock2Driver {
 public:
   struct Config {
     std::string clock_name;  //!< Shared memory name for the clock (must start with '/')
+
+    /// Sleepers with deadlines this close together share a futex word and are woken together.
+    /// Smaller means more futex wake calls per tick, larger means more early wake-ups to re-check
+    EgoClock2::Duration wake_resolution{ std::chrono::milliseconds(1) };
+
+    /// Shared memory name of a registry (must start with '/') to publish the clock in, instead of
+    /// creating a segment for it. Hosts running many clocks then map one segment for all of them.
+    /// The clock name is then only a key in the registry, of up to 63 characters. The registry
+    /// segment is created on first use and left in place for other drivers. A driver fails to start
+    /// while another process is running a clock of the same name in the registry.
+    std::string registry_name{};
+
+    /// File to record ticks to (see EgoClockTickLogWriter), or empty. Wall times recorded are from
+    /// the steady clock, as used to estimate the tick rate
+    std::string tick_log{};
   };
 
   /// Construct and start the driver
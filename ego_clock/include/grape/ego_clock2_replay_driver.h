@@ -0,0 +1,55 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <stop_token>
+#include <string>
+
+#include "grape/ego_clock2_driver.h"
+
+namespace grape {
+
+//=================================================================================================
+/// Drives EgoClock2 consumers from a recorded tick log
+///
+/// Re-posts the ego times in a log written by a driver with Config::tick_log set (see
+/// EgoClockTickLogWriter), for deterministic replay of a recorded session. Ticks are posted as
+/// fast as possible, or paced by the recorded wall times sped up by a given factor. Hours of
+/// recorded time can so be run through consumers in seconds.
+class EgoClock2ReplayDriver {
+public:
+  struct Config {
+    std::string tick_log;            //!< File to replay
+    EgoClock2Driver::Config driver;  //!< Clock to post ticks to. tick_log is ignored
+
+    /// How many times faster than recorded to replay. 0 posts ticks as fast as possible
+    double speed{ 0. };
+  };
+
+  /// Open the log and start the driver
+  /// @param config Configuration parameters. Throws std::runtime_error if the log can't be read or
+  /// the driver can't be started
+  explicit EgoClock2ReplayDriver(const Config& config);
+
+  /// Post ticks from the log until it ends or a stop is requested. May be called again to carry on
+  /// where it stopped
+  /// @param stop_token Stops replay before the next tick
+  /// @return Number of ticks posted
+  auto run(const std::stop_token& stop_token = {}) -> std::size_t;
+
+  ~EgoClock2ReplayDriver();
+  EgoClock2ReplayDriver(const EgoClock2ReplayDriver&) = delete;
+  EgoClock2ReplayDriver(EgoClock2ReplayDriver&&) = delete;
+  auto operator=(const EgoClock2ReplayDriver&) = delete;
+  auto operator=(EgoClock2ReplayDriver&&) = delete;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_{ nullptr };
+};
+
+}  // namespace grape
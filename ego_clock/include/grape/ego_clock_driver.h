@@ -22,6 +22,8 @@ public:
     std::string clock_name;                    //!< Uniquely identifies clock source
     WallClock::Duration broadcast_interval{};  //!< Interval between system-wide clock sync tx
     std::size_t calibration_window{ 2U };  //!< Number of tick samples used to evaluate clock fit
+    bool robust_fit{ false };  //!< Down-weight outlier ticks (e.g. late ticks from a busy master)
+    std::string tick_log{};    //!< File to record ticks to (see EgoClockTickLogWriter), or empty
   };
 
   /// Construct and start the driver
@@ -33,6 +35,10 @@ public:
   /// @param wall_time Corresponding wall clock time (UTC)
   void tick(const EgoClock::TimePoint& ego_time, const WallClock::TimePoint& wall_time);
 
+  /// @return Sequence number of the last clock fit broadcast (see EgoClock::CheckedTime), or 0 if
+  /// none yet. Changes in the tick() call that broadcasts it
+  [[nodiscard]] auto sequence() const -> std::uint64_t;
+
   ~EgoClockDriver();
   EgoClockDriver(const EgoClockDriver&) = delete;
   EgoClockDriver(EgoClockDriver&&) = delete;
@@ -0,0 +1,95 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace grape {
+
+//=================================================================================================
+/// A tick as given to a clock driver: ego time, and the time of the driver's reference clock then
+/// (WallClock for EgoClockDriver, steady clock for EgoClock2Driver)
+struct EgoClockTick {
+  std::int64_t ego_nanos{ 0 };
+  std::int64_t wall_nanos{ 0 };
+
+  [[nodiscard]] auto operator==(const EgoClockTick&) const -> bool = default;
+};
+
+//=================================================================================================
+/// Appends ticks to a tick log file, for replay with EgoClock2ReplayDriver
+///
+/// Ticks are delta-encoded into a few bytes each (see ego_clock::TickLogFormat) and written in
+/// blocks of BUFFER_SIZE bytes, and when the writer is flushed or destroyed. Opening an existing
+/// log carries on at its end. Drivers write one when given Config::tick_log.
+class EgoClockTickLogWriter {
+public:
+  static constexpr auto BUFFER_SIZE = std::size_t{ 4096U };
+
+  /// Open a log for appending, creating it if it doesn't exist
+  /// @param path File to write to. Throws std::runtime_error if it can't be opened, or already
+  /// holds something other than a tick log
+  explicit EgoClockTickLogWriter(const std::string& path);
+
+  /// Append a tick
+  void append(const EgoClockTick& tick);
+
+  /// Write buffered ticks to the file
+  void flush();
+
+  ~EgoClockTickLogWriter();
+  EgoClockTickLogWriter(const EgoClockTickLogWriter&) = delete;
+  EgoClockTickLogWriter(EgoClockTickLogWriter&&) = delete;
+  auto operator=(const EgoClockTickLogWriter&) = delete;
+  auto operator=(EgoClockTickLogWriter&&) = delete;
+
+private:
+  int fd_{ -1 };
+  std::string path_;
+  EgoClockTick last_{};
+  std::vector<std::byte> buffer_;
+};
+
+//=================================================================================================
+/// Reads ticks from a tick log file, mapped into memory
+///
+/// Sees the ticks in the log when it was opened. Ticks appended since are picked up by opening
+/// the log again.
+class EgoClockTickLogReader {
+public:
+  /// Map a log for reading
+  /// @param path File to read. Throws std::runtime_error if it can't be mapped, or isn't a tick log
+  explicit EgoClockTickLogReader(const std::string& path);
+
+  /// @return The next tick, or nothing at the end of the log
+  [[nodiscard]] auto next() -> std::optional<EgoClockTick>;
+
+  /// Go back to the first tick
+  void rewind();
+
+  /// @return Offset in the file of the first byte not yet read. At the end of the log, this is
+  /// where the next tick will be appended
+  [[nodiscard]] auto offset() const -> std::size_t {
+    return offset_;
+  }
+
+  ~EgoClockTickLogReader();
+  EgoClockTickLogReader(const EgoClockTickLogReader&) = delete;
+  EgoClockTickLogReader(EgoClockTickLogReader&&) = delete;
+  auto operator=(const EgoClockTickLogReader&) = delete;
+  auto operator=(EgoClockTickLogReader&&) = delete;
+
+private:
+  std::span<const std::byte> data_;
+  std::size_t offset_{ 0U };
+  EgoClockTick last_{};
+};
+
+}  // namespace grape
@@ -4,38 +4,85 @@
 
 #include "clock_data_receiver.h"
 
-#include <thread>
+#include <utility>
 
 #include "grape/log/syslog.h"
 
 namespace grape::ego_clock {
 
 //-------------------------------------------------------------------------------------------------
-ClockDataReceiver::ClockDataReceiver(const std::string& clock_name)
-  : tick_sub_(
+ClockDataReceiver::ClockDataReceiver(const std::string& clock_name,
+                                     WallClock::Duration slew_window,
+                                     EgoClock::TimeSource time_source)
+  : slew_window_(slew_window)
+  , tsc_((time_source == EgoClock::TimeSource::Tsc and TscClock::isAvailable()) ?
+             std::make_optional<TscCalibration>() :
+             std::nullopt)
+  , tick_sub_(
         ClockTopic(clock_name), [this](const auto& data, const auto& info) { onTick(data, info); },
         [this](const auto& match) { onMatch(match); }) {
 }
 
 //-------------------------------------------------------------------------------------------------
-auto ClockDataReceiver::transform() -> ClockTransform {
-  ClockTransform tf;
-  while (true) {
-    // Avoid torn reads: retry if writer is active (odd or changed seq)
-    const auto seq_before = seq_.load(std::memory_order_relaxed);
-    tf = transform_;
-    const auto seq_after = seq_.load(std::memory_order_acquire);
-    if ((seq_before == seq_after) and ((seq_before & 1U) == 0U)) {
-      break;
-    }
-    std::this_thread::yield();
+auto ClockDataReceiver::transform() const -> ClockTransform {
+  return transform_.load().target;
+}
+
+//-------------------------------------------------------------------------------------------------
+auto ClockDataReceiver::now() const -> EgoClock::TimePoint {
+  // Sample the time source within the seqlock read, so that it is read before any new transform's
+  // slew starts. A later call, seeing the new transform, then can't get an earlier time
+  if (tsc_) {
+    return EgoClock::fromNanos(transform_.read([] { return TscClock::now(); }, toEgoNanos));
+  }
+  return EgoClock::fromNanos(
+      transform_.read([] { return WallClock::toNanos(WallClock::now()); }, toEgoNanos));
+}
+
+//-------------------------------------------------------------------------------------------------
+auto ClockDataReceiver::read() const -> ClockReading {
+  // Slower than now(): reads the wall clock as well as the TSC, and copies the transform out
+  const auto sample = [this] {
+    const auto wall_now = WallClock::now();
+    return std::pair{ wall_now, tsc_ ? TscClock::now() : WallClock::toNanos(wall_now) };
+  };
+  return transform_.read(sample, [](const SlewedTransform& tf, const auto& sampled) {
+    const auto& [wall_now, ticks] = sampled;
+    return ClockReading{ .time = EgoClock::fromNanos(toEgoNanos(tf, ticks)),
+                         .wall_time = wall_now,
+                         .transform = tf.target };
+  });
+}
+
+//-------------------------------------------------------------------------------------------------
+auto ClockDataReceiver::wallTimeUntil(const EgoClock::TimePoint& tp) const
+    -> WallClock::Duration {
+  const auto ego_ns = EgoClock::toNanos(tp);
+  return transform_.read(
+      [this] { return tsc_ ? TscClock::now() : WallClock::toNanos(WallClock::now()); },
+      [ego_ns](const SlewedTransform& tf, std::int64_t ticks) {
+        return ego_clock::wallTimeUntil(tf, ticks, ego_ns);
+      });
+}
+
+//-------------------------------------------------------------------------------------------------
+auto ClockDataReceiver::timeSource() const -> EgoClock::TimeSource {
+  return tsc_ ? EgoClock::TimeSource::Tsc : EgoClock::TimeSource::WallClock;
+}
+
+//-------------------------------------------------------------------------------------------------
+auto ClockDataReceiver::sampleTime() -> TimeSample {
+  if (tsc_) {
+    const auto sample = tsc_->update();
+    return { .wall_ns = sample.wall_ns, .ticks = sample.ticks, .ns_per_tick = tsc_->nsPerTick() };
   }
-  return tf;
+  const auto wall_ns = WallClock::toNanos(WallClock::now());
+  return { .wall_ns = wall_ns, .ticks = wall_ns };
 }
 
 //-------------------------------------------------------------------------------------------------
 auto ClockDataReceiver::isInit() const -> bool {
-  const auto seq = seq_.load(std::memory_order_relaxed);
+  const auto seq = transform_.version();
   return (seq != 0U) and ((seq & 1U) == 0U);
 }
 
@@ -50,9 +97,9 @@ void ClockDataReceiver::onTick(const std::expected<ClockTransform, ipc::Error>&
     syslog::Error("Error receiving clock data: {}", toString(maybe_data.error()));
     return;
   }
-  seq_.fetch_add(1, std::memory_order_relaxed);  // Begin write (odd count)
-  transform_ = maybe_data.value();
-  seq_.fetch_add(1, std::memory_order_release);  // End write (even count)
+  transform_.update([this, &maybe_data](const SlewedTransform& current) {
+    return slewTo(current, maybe_data.value(), sampleTime(), slew_window_);
+  });
 }
 
 //-------------------------------------------------------------------------------------------------
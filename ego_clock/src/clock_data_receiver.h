@@ -5,28 +5,51 @@
 #pragma once
 
 #include <atomic>
+#include <optional>
 
+#include "clock_slew.h"
 #include "clock_topic.h"
 #include "grape/ipc/subscriber.h"
+#include "seqlock.h"
+#include "tsc_clock.h"
 
 namespace grape::ego_clock {
 
+/// Ego time, with the wall clock time and the transform it was read with
+struct ClockReading {
+  EgoClock::TimePoint time;
+  WallClock::TimePoint wall_time;
+  ClockTransform transform;  //!< Latest transform from the driver, being slewed into
+};
+
 //=================================================================================================
 /// Receives clock ticks from ego clock driver
+///
+/// New clock transforms are slewed into over at least 'slew_window' (see SlewedTransform), so that
+/// now() is monotonic for each thread calling it. With EgoClock::TimeSource::Tsc, they are slewed
+/// in TSC ticks, recalibrating the TSC against the wall clock on every transform received.
 class ClockDataReceiver {
 public:
-  explicit ClockDataReceiver(const std::string& clock_name);
+  ClockDataReceiver(const std::string& clock_name, WallClock::Duration slew_window,
+                    EgoClock::TimeSource time_source);
   [[nodiscard]] auto isInit() const -> bool;
-  [[nodiscard]] auto transform() -> ClockTransform;
+  [[nodiscard]] auto transform() const -> ClockTransform;
+  [[nodiscard]] auto now() const -> EgoClock::TimePoint;
+  [[nodiscard]] auto read() const -> ClockReading;  //!< now(), consistent with its transform
+  /// @return Wall clock time until now() reaches 'tp' on the transform in use. Zero once it has
+  [[nodiscard]] auto wallTimeUntil(const EgoClock::TimePoint& tp) const -> WallClock::Duration;
+  [[nodiscard]] auto timeSource() const -> EgoClock::TimeSource;
 
 private:
   void onMatch(const ipc::Match& match);
   void onTick(const std::expected<ClockTransform, ipc::Error>& maybe_data,
               const ipc::SampleInfo& info);
+  [[nodiscard]] auto sampleTime() -> TimeSample;
 
   std::atomic<std::size_t> num_masters_{ 0U };
-  std::atomic<std::uint64_t> seq_{ 0U };
-  ClockTransform transform_;
+  WallClock::Duration slew_window_;
+  std::optional<TscCalibration> tsc_;  //!< Set if the time source is the TSC
+  SeqLock<SlewedTransform> transform_;
   ipc::Subscriber<ClockTopic> tick_sub_;
 };
 
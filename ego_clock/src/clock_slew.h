@@ -0,0 +1,109 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+
+#include "clock_transform.h"
+
+namespace grape::ego_clock {
+
+//=================================================================================================
+/// Clock transform being slewed into, as adjtime() does for NTP
+///
+/// When a new transform arrives, ego time continues from where the previous one had got to, at the
+/// new rate, and catches up the difference (offset) linearly over a slew window:
+///
+///   ego_ns = start_ego_ns + rate.dt + progress.offset, where
+///   dt = ticks - start_ticks and progress = clamp(dt / window, 0, 1)
+///
+/// so ego time never steps. When moving backwards, the window is stretched so that ego time still
+/// advances at least at MIN_SLEW_RATE times the new rate, hence is monotonic.
+///
+/// Time is measured in ticks of the time source: wall clock nanoseconds, or TSC ticks (see
+/// TscClock). The conversion from ticks to wall clock time is folded into rate and window, so that
+/// either costs the same to read.
+struct SlewedTransform {
+  ClockTransform target;           //!< Latest transform from the driver
+  std::int64_t start_ticks{ 0 };   //!< Time source reading the slew started at. 0 if none yet
+  std::int64_t start_ego_ns{ 0 };  //!< Ego time shown at start_ticks
+  double rate{ 1. };               //!< Ego nanoseconds per tick (ns_per_tick / target.scale)
+  double offset{ 0. };             //!< Ego nanoseconds to catch up by the end of the slew
+  double inv_window{ 1. };         //!< 1 / slew window in ticks
+};
+
+/// Reading of the time source, with the wall clock time it corresponds to
+struct TimeSample {
+  std::int64_t wall_ns{ 0 };
+  std::int64_t ticks{ 0 };    //!< Time source reading. Same as wall_ns if it is the wall clock
+  double ns_per_tick{ 1. };  //!< Wall clock nanoseconds per tick of the time source
+};
+
+/// Lowest rate of ego time during a slew backwards, relative to the target rate
+constexpr auto MIN_SLEW_RATE = 0.5;
+
+//-------------------------------------------------------------------------------------------------
+/// @return Ego time at a time source reading, following a slewed transform
+constexpr auto toEgoNanos(const SlewedTransform& tf, std::int64_t ticks) -> std::int64_t {
+  const auto dt = static_cast<double>(ticks - tf.start_ticks);
+  const auto progress = std::clamp(dt * tf.inv_window, 0., 1.);
+  return tf.start_ego_ns + static_cast<std::int64_t>(std::fma(progress, tf.offset, dt * tf.rate));
+}
+
+//-------------------------------------------------------------------------------------------------
+/// @return Wall clock time from a time source reading until a slewed transform reaches an ego
+/// time (inverse of toEgoNanos), or zero if it already has at that reading
+constexpr auto wallTimeUntil(const SlewedTransform& tf, std::int64_t ticks, std::int64_t ego_ns)
+    -> WallClock::Duration {
+  if (toEgoNanos(tf, ticks) >= ego_ns) {
+    return WallClock::Duration::zero();
+  }
+  const auto ego_dt = static_cast<double>(ego_ns - tf.start_ego_ns);
+  const auto slew_end_ego_dt = tf.rate / tf.inv_window + tf.offset;
+  auto dt = ego_dt / tf.rate;  // before the slew started
+  if (ego_dt > 0. and ego_dt < slew_end_ego_dt) {
+    dt = ego_dt / std::fma(tf.offset, tf.inv_window, tf.rate);
+  } else if (ego_dt >= slew_end_ego_dt) {
+    dt = (ego_dt - tf.offset) / tf.rate;
+  }
+  // rate is ego nanoseconds per tick and target.scale wall nanoseconds per ego nanosecond. At
+  // least 1 ns, however the inverse rounds, as the ego time isn't reached yet
+  const auto wait_ticks = dt - static_cast<double>(ticks - tf.start_ticks);
+  const auto wait_ns = std::ceil(wait_ticks * tf.rate * tf.target.scale);
+  return std::max(WallClock::Duration(1), std::chrono::duration_cast<WallClock::Duration>(
+                                              std::chrono::nanoseconds(std::llround(wait_ns))));
+}
+
+//-------------------------------------------------------------------------------------------------
+/// Start slewing to a new transform
+/// @param current Transform in use, to slew from
+/// @param target New transform from the driver
+/// @param now Time source now, at which the slew starts
+/// @param min_window Shortest time to slew over. Zero steps forwards at once
+/// @return Transform to use from now on
+constexpr auto slewTo(const SlewedTransform& current, const ClockTransform& target,
+                      const TimeSample& now, WallClock::Duration min_window) -> SlewedTransform {
+  const auto target_ego_ns =
+      EgoClock::toNanos(toEgoTime(target, WallClock::fromNanos(now.wall_ns)));
+  const auto is_first = (current.start_ticks == 0);
+  const auto start_ego_ns = is_first ? target_ego_ns : toEgoNanos(current, now.ticks);
+  const auto rate = now.ns_per_tick / target.scale;
+  const auto offset = static_cast<double>(target_ego_ns - start_ego_ns);
+
+  // d(ego_ns)/dt = rate + offset / window >= MIN_SLEW_RATE.rate
+  const auto min_backwards_window = -offset / ((1. - MIN_SLEW_RATE) * rate);
+  const auto min_window_ticks = static_cast<double>(min_window.count()) / now.ns_per_tick;
+  const auto window = std::max({ 1., min_window_ticks, min_backwards_window });
+  return { .target = target,
+           .start_ticks = now.ticks,
+           .start_ego_ns = start_ego_ns,
+           .rate = rate,
+           .offset = offset,
+           .inv_window = 1. / window };
+}
+
+}  // namespace grape::ego_clock
@@ -13,13 +13,25 @@ namespace grape::ego_clock {
 //-------------------------------------------------------------------------------------------------
 template <serdes::WritableStream S>
 constexpr auto serialise(serdes::Serialiser<S>& ser, const ClockTransform& data) -> bool {
-  return ser.pack(data.scale) and ser.pack(data.offset) and ser.pack(data.rmse);
+  return ser.pack(data.ego_origin_ns) and ser.pack(data.wall_origin_ns) and ser.pack(data.scale) and
+         ser.pack(data.offset) and ser.pack(data.rmse) and ser.pack(data.sequence) and
+         ser.pack(WallClock::toNanos(data.fit_time)) and
+         ser.pack(WallClock::toNanos(data.valid_until));
 }
 
 //-------------------------------------------------------------------------------------------------
 template <serdes::ReadableStream S>
 constexpr auto deserialise(serdes::Deserialiser<S>& des, ClockTransform& data) -> bool {
-  return des.unpack(data.scale) and des.unpack(data.offset) and des.unpack(data.rmse);
+  auto fit_time_ns = std::int64_t{};
+  auto valid_until_ns = std::int64_t{};
+  if (not(des.unpack(data.ego_origin_ns) and des.unpack(data.wall_origin_ns) and
+          des.unpack(data.scale) and des.unpack(data.offset) and des.unpack(data.rmse) and
+          des.unpack(data.sequence) and des.unpack(fit_time_ns) and des.unpack(valid_until_ns))) {
+    return false;
+  }
+  data.fit_time = WallClock::fromNanos(fit_time_ns);
+  data.valid_until = WallClock::fromNanos(valid_until_ns);
+  return true;
 }
 
 //=================================================================================================
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cinttypes>
 #include <cmath>
 #include <format>
 
@@ -14,30 +15,44 @@ namespace grape::ego_clock {
 
 //=================================================================================================
 /// Data for fitting correspondance between ego-clock and wall-clock
-/// wall_clock_ns = scale * ego_clock_ns + offset
+/// wall_clock_ns = wall_origin_ns + scale * (ego_clock_ns - ego_origin_ns) + offset
+///
+/// Relative to an origin, as nanoseconds since the epoch (~1e18) don't fit in a double exactly but
+/// nanoseconds since the origin do for over 100 days
 struct ClockTransform {
+  std::int64_t ego_origin_ns{ 0 };   //!< Ego time the fit is relative to (the driver's first tick)
+  std::int64_t wall_origin_ns{ 0 };  //!< Wall time the fit is relative to
   double scale{ 1. };
-  double offset{ 0. };
+  double offset{ 0. };  //!< Wall nanoseconds after wall_origin_ns at ego_origin_ns
   double rmse{ 0. };
+  std::uint64_t sequence{ 0U };        //!< Incremented by the driver with every broadcast
+  WallClock::TimePoint fit_time{};     //!< Wall clock time of the tick the fit was made at
+  WallClock::TimePoint valid_until{};  //!< Wall clock time after which the transform is stale
 };
 
 //-------------------------------------------------------------------------------------------------
 constexpr auto toString(const ClockTransform& tf) -> std::string {
-  return std::format("scale={}, offset={}, rmse={}", tf.scale, tf.offset, tf.rmse);
+  return std::format(
+      "ego_origin={}, wall_origin={}, scale={}, offset={}, rmse={}, sequence={}, fit_time={}, "
+      "valid_until={}",
+      tf.ego_origin_ns, tf.wall_origin_ns, tf.scale, tf.offset, tf.rmse, tf.sequence,
+      WallClock::toNanos(tf.fit_time), WallClock::toNanos(tf.valid_until));
 }
 
 //-------------------------------------------------------------------------------------------------
 constexpr auto toWallTime(const ClockTransform& tf, const EgoClock::TimePoint& tp)
     -> WallClock::TimePoint {
-  const auto ns = std::fma(tf.scale, static_cast<double>(EgoClock::toNanos(tp)), tf.offset);
-  return grape::WallClock::fromNanos(static_cast<std::int64_t>(ns));
+  const auto ego_dt = static_cast<double>(EgoClock::toNanos(tp) - tf.ego_origin_ns);
+  return grape::WallClock::fromNanos(tf.wall_origin_ns +
+                                     std::llround(std::fma(tf.scale, ego_dt, tf.offset)));
 }
 
 //-------------------------------------------------------------------------------------------------
 constexpr auto toEgoTime(const ClockTransform& tf, const WallClock::TimePoint& tp)
     -> EgoClock::TimePoint {
-  const auto ns = (static_cast<double>(WallClock::toNanos(tp)) - tf.offset) / tf.scale;
-  return grape::EgoClock::fromNanos(static_cast<std::int64_t>(ns));
+  const auto wall_dt = static_cast<double>(WallClock::toNanos(tp) - tf.wall_origin_ns);
+  return grape::EgoClock::fromNanos(tf.ego_origin_ns +
+                                    std::llround((wall_dt - tf.offset) / tf.scale));
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -46,4 +61,10 @@ constexpr auto toWallDuration(const ClockTransform& tf, const EgoClock::Duration
   return std::chrono::duration_cast<WallClock::Duration>(dur * tf.scale);
 }
 
+//-------------------------------------------------------------------------------------------------
+constexpr auto toEgoDuration(const ClockTransform& tf, const WallClock::Duration& dur)
+    -> EgoClock::Duration {
+  return std::chrono::duration_cast<EgoClock::Duration>(dur / tf.scale);
+}
+
 }  // namespace grape::ego_clock
@@ -4,6 +4,7 @@
 
 #include "grape/ego_clock.h"
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
@@ -12,9 +13,15 @@
 
 namespace grape {
 
+namespace {
+/// Worst expected relative drift between ego and wall clocks (e.g. two free running crystals)
+constexpr auto MAX_DRIFT = 100e-6;
+}  // namespace
+
 //-------------------------------------------------------------------------------------------------
-EgoClock::EgoClock(const std::string& system_name)
-  : rx_(std::make_unique<ego_clock::ClockDataReceiver>(system_name)) {
+EgoClock::EgoClock(const std::string& system_name, const std::chrono::milliseconds& slew_window,
+                   TimeSource time_source)
+  : rx_(std::make_unique<ego_clock::ClockDataReceiver>(system_name, slew_window, time_source)) {
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -24,30 +31,61 @@ EgoClock::~EgoClock() = default;
 EgoClock::EgoClock(EgoClock&&) noexcept = default;
 
 //-------------------------------------------------------------------------------------------------
-auto EgoClock::create(const std::string& clock_name, const std::chrono::milliseconds& timeout)
+auto EgoClock::create(const std::string& clock_name, const std::chrono::milliseconds& timeout,
+                      const std::chrono::milliseconds& slew_window, TimeSource time_source)
     -> std::optional<EgoClock> {
   const auto until = WallClock::now() + timeout;
   static constexpr auto LOOP_WAIT = std::chrono::milliseconds(1);
-  auto clock = EgoClock(clock_name);
+  auto clock = EgoClock(clock_name, slew_window, time_source);
   while (not clock.rx_->isInit() and (WallClock::now() < until)) {
     std::this_thread::sleep_for(LOOP_WAIT);
   }
   return clock.rx_->isInit() ? std::optional<EgoClock>(std::move(clock)) : std::nullopt;
 }
 
+//-------------------------------------------------------------------------------------------------
+auto EgoClock::timeSource() const -> TimeSource {
+  return rx_->timeSource();
+}
+
 //-------------------------------------------------------------------------------------------------
 auto EgoClock::now() const noexcept -> EgoClock::TimePoint {
-  return ego_clock::toEgoTime(rx_->transform(), WallClock::now());
+  return rx_->now();
+}
+
+//-------------------------------------------------------------------------------------------------
+auto EgoClock::nowChecked() const noexcept -> CheckedTime {
+  // One snapshot, so that the time, staleness and sequence all come from the same transform
+  const auto reading = rx_->read();
+  const auto& tf = reading.transform;
+  const auto expired_for =
+      std::max(WallClock::Duration::zero(), reading.wall_time - tf.valid_until);
+  const auto staleness = ego_clock::toEgoDuration(tf, expired_for);
+  const auto rmse = EgoClock::Duration(static_cast<std::int64_t>(tf.rmse));
+  // The clocks drift apart from the time of the fit, not just once it expires
+  const auto since_fit = std::max(WallClock::Duration::zero(), reading.wall_time - tf.fit_time);
+  const auto drift = std::chrono::duration_cast<EgoClock::Duration>(
+      ego_clock::toEgoDuration(tf, since_fit) * MAX_DRIFT);
+  return CheckedTime{ .time = reading.time,
+                      .staleness = staleness,
+                      .uncertainty = rmse + drift,
+                      .sequence = tf.sequence };
 }
 
 //-------------------------------------------------------------------------------------------------
 void EgoClock::sleepFor(const EgoClock::Duration& dt) const {
-  std::this_thread::sleep_for(ego_clock::toWallDuration(rx_->transform(), dt));
+  sleepUntil(now() + dt);
 }
 
 //-------------------------------------------------------------------------------------------------
 void EgoClock::sleepUntil(const EgoClock::TimePoint& tp) const {
-  std::this_thread::sleep_until(ego_clock::toWallTime(rx_->transform(), tp));
+  // Follows the slewed transform now() does, and checks again on waking in case a new transform
+  // arrived meanwhile, so that now() >= tp on return
+  auto wait = rx_->wallTimeUntil(tp);
+  while (wait > WallClock::Duration::zero()) {
+    std::this_thread::sleep_for(wait);
+    wait = rx_->wallTimeUntil(tp);
+  }
 }
 
 }  // namespace grape
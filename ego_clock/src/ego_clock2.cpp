@@ -4,24 +4,120 @@
 
 #include "grape/ego_clock2.h"
 
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
 #include <thread>
+#include <utility>
 
+#include "ego_clock2_registry.h"
 #include "ego_clock2_signal.h"
 #include "grape/realtime/shared_memory.h"
 
+namespace {
+
+using Registry = grape::ego_clock::EgoClock2Registry;
+
+struct Mapping {
+  std::shared_ptr<grape::realtime::SharedMemory> shm;  //!< Holding the signal
+  const grape::ego_clock::EgoClock2Signal* signal{ nullptr };
+  const Registry::Slot* slot{ nullptr };  //!< Slot of the signal, if in a registry
+  std::uint32_t incarnation{ 0U };        //!< Of the slot when found to hold the clock
+};
+
+//-------------------------------------------------------------------------------------------------
+// @return Mapping holding the signal of a clock, with the signal. Nothing if the driver hasn't
+// created it yet
+auto openSignal(const std::string& clock_name, const std::string& registry_name)
+    -> std::optional<Mapping> {
+  using Shm = grape::realtime::SharedMemory;
+  if (registry_name.empty()) {
+    // Writable for the waiter counts of the signal (see EgoClock2Signal)
+    auto maybe_shm = Shm::open(clock_name, Shm::Access::ReadWrite);
+    if (not maybe_shm) {
+      return std::nullopt;
+    }
+    auto shm = std::make_shared<Shm>(std::move(maybe_shm.value()));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto* signal = reinterpret_cast<const grape::ego_clock::EgoClock2Signal*>(
+        shm->data().data());
+    return Mapping{ .shm = std::move(shm), .signal = signal };
+  }
+
+  // Registry already mapped if any other clock of this process uses it: just a lookup
+  auto shm = grape::ego_clock::mapRegistry(registry_name, false);
+  if (shm == nullptr) {
+    return std::nullopt;
+  }
+  const auto* slot = grape::ego_clock::registryIn(*shm)->findSlot(clock_name);
+  if (slot == nullptr) {
+    return std::nullopt;
+  }
+  // Check the slot still holds the clock after reading the incarnation, so that it is this clock's
+  const auto incarnation = slot->incarnation.load(std::memory_order_acquire);
+  if (not Registry::isRegistered(*slot, clock_name)) {
+    return std::nullopt;
+  }
+  return Mapping{
+    .shm = std::move(shm), .signal = &slot->signal, .slot = slot, .incarnation = incarnation
+  };
+}
+
+}  // namespace
+
 namespace grape {
 
 //-------------------------------------------------------------------------------------------------
 struct EgoClock2::Impl {
-  explicit Impl(realtime::SharedMemory&& shm_in);
-  realtime::SharedMemory shm;
+  std::shared_ptr<realtime::SharedMemory> shm;  //!< Own segment, or registry shared with others
   const ego_clock::EgoClock2Signal* signal{ nullptr };
+  const Registry::Slot* slot{ nullptr };  //!< Slot holding the signal, if in a registry
+  std::string clock_name;
+  mutable std::atomic<std::uint32_t> incarnation{ 0U };  //!< Of the slot, as last seen to be ours
+  mutable std::atomic<std::int64_t> last_nanos{ 0 };     //!< Latest tick seen from our driver
+
+  /// @return Whether the signal is still this clock's: false once the slot of a registry clock has
+  /// been claimed for another clock, or while being claimed again
+  [[nodiscard]] auto isAttached() const -> bool;
+
+  /// @return Whether the slot of a registry clock is now another clock's
+  [[nodiscard]] auto isDetached() const -> bool;
+
+  /// Record the latest tick seen, to stop at if detached
+  void record(const ego_clock::EgoClock2Tick& tick) const;
 };
 
 //-------------------------------------------------------------------------------------------------
-EgoClock2::Impl::Impl(realtime::SharedMemory&& shm_in) : shm(std::move(shm_in)) {
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-  signal = reinterpret_cast<const ego_clock::EgoClock2Signal*>(shm.data().data());
+auto EgoClock2::Impl::isAttached() const -> bool {
+  if (slot == nullptr) {
+    return true;
+  }
+  const auto current = slot->incarnation.load(std::memory_order_acquire);
+  if (current == incarnation.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  // Claimed again since: still ours if by a new session of our driver
+  if (not Registry::isRegistered(*slot, clock_name) or
+      (slot->incarnation.load(std::memory_order_acquire) != current)) {
+    return false;
+  }
+  incarnation.store(current, std::memory_order_relaxed);
+  return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+auto EgoClock2::Impl::isDetached() const -> bool {
+  return not isAttached() and (slot->owner.load(std::memory_order_acquire).state !=
+                               Registry::SlotState::Claimed);
+}
+
+//-------------------------------------------------------------------------------------------------
+void EgoClock2::Impl::record(const ego_clock::EgoClock2Tick& tick) const {
+  const auto seen = std::max(tick.ego_nanos, tick.floor_nanos);
+  auto last = last_nanos.load(std::memory_order_relaxed);
+  while ((last < seen) and
+         not last_nanos.compare_exchange_weak(last, seen, std::memory_order_relaxed)) {
+  }
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -35,23 +131,28 @@ EgoClock2::~EgoClock2() = default;
 EgoClock2::EgoClock2(EgoClock2&&) noexcept = default;
 
 //-------------------------------------------------------------------------------------------------
-auto EgoClock2::create(const std::string& clock_name, const std::chrono::milliseconds& timeout)
-    -> std::optional<EgoClock2> {
-  using Shm = realtime::SharedMemory;
+auto EgoClock2::create(const std::string& clock_name, const std::chrono::milliseconds& timeout,
+                       const std::string& registry_name) -> std::optional<EgoClock2> {
   const auto end = std::chrono::steady_clock::now() + timeout;
   static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(1);
 
   // Wait for the shared memory to be created by the driver
-  auto maybe_shm = Shm::open(clock_name, Shm::Access::ReadOnly);
-  while (not maybe_shm) {
+  auto maybe_mapping = openSignal(clock_name, registry_name);
+  while (not maybe_mapping) {
     if (std::chrono::steady_clock::now() >= end) {
       return std::nullopt;
     }
     std::this_thread::sleep_for(POLL_INTERVAL);
-    maybe_shm = Shm::open(clock_name, Shm::Access::ReadOnly);
+    maybe_mapping = openSignal(clock_name, registry_name);
   }
 
-  auto impl = std::make_unique<Impl>(std::move(maybe_shm.value()));
+  auto& mapping = maybe_mapping.value();
+  auto impl = std::make_unique<Impl>();
+  impl->shm = std::move(mapping.shm);
+  impl->signal = mapping.signal;
+  impl->slot = mapping.slot;
+  impl->clock_name = clock_name;
+  impl->incarnation = mapping.incarnation;
 
   // Wait for the first tick (nanos > 0)
   while (impl->signal->get() == 0) {
@@ -68,19 +169,40 @@ auto EgoClock2::create(const std::string& clock_name, const std::chrono::millise
 
 //-------------------------------------------------------------------------------------------------
 auto EgoClock2::now() const noexcept -> EgoClock2::TimePoint {
-  return EgoClock2::fromNanos(impl_->signal->get());
+  // Same clock as the driver uses to timestamp ticks (CLOCK_MONOTONIC), shared by all processes
+  const auto wall_nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+  const auto tick = impl_->signal->getTick();
+  if (impl_->slot == nullptr) {
+    return EgoClock2::fromNanos(ego_clock::interpolate(tick, wall_nanos));
+  }
+  // Checked after reading the tick: a claim changes the incarnation before the tick
+  if (not impl_->isAttached()) {
+    return EgoClock2::fromNanos(impl_->last_nanos.load(std::memory_order_relaxed));
+  }
+  impl_->record(tick);
+  return EgoClock2::fromNanos(ego_clock::interpolate(tick, wall_nanos));
 }
 
 //-------------------------------------------------------------------------------------------------
 void EgoClock2::sleepUntil(const EgoClock2::TimePoint& tp) const {
-  // Block on futex ticks until the ego clock reaches the target time.
+  // Block until a tick reaches the target time. The driver only wakes sleepers whose deadlines its
+  // ticks have reached, so this normally wakes once.
   // TICK_WAIT_TIMEOUT guards against indefinite blocking if the driver stops posting ticks.
   static constexpr auto TICK_WAIT_TIMEOUT = std::chrono::milliseconds(100);
-  auto current_nanos = impl_->signal->get();
-  while (EgoClock2::fromNanos(current_nanos) < tp) {
-    std::ignore = impl_->signal->wait(current_nanos, TICK_WAIT_TIMEOUT);
-    current_nanos = impl_->signal->get();
+  const auto deadline = EgoClock2::toNanos(tp);
+  const auto check_attached = [this] {
+    if (impl_->isDetached()) {
+      throw std::runtime_error("EgoClock2: Clock '" + impl_->clock_name +
+                               "' was released by its driver, and its registry slot reused");
+    }
+  };
+  while (impl_->signal->get() < deadline) {
+    check_attached();
+    std::ignore = impl_->signal->waitUntil(deadline, TICK_WAIT_TIMEOUT);
   }
+  check_attached();  // reached by another clock's ticks?
 }
 
 //-------------------------------------------------------------------------------------------------
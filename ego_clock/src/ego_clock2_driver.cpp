@@ -4,40 +4,68 @@
 
 #include "grape/ego_clock2_driver.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
 #include <stdexcept>
 
+#include "ego_clock2_registry.h"
 #include "ego_clock2_signal.h"
+#include "grape/ego_clock_tick_log.h"
 #include "grape/realtime/shared_memory.h"
 
 namespace grape {
 
 //-------------------------------------------------------------------------------------------------
 struct EgoClock2Driver::Impl {
-  Impl(const Config& config, realtime::SharedMemory&& shm_in);
   ~Impl();
-  realtime::SharedMemory shm;
+  std::shared_ptr<realtime::SharedMemory> shm;  //!< Own segment, or registry shared with others
+  ego_clock::EgoClock2Registry* registry{ nullptr };  //!< Registry holding the signal, if any
   ego_clock::EgoClock2Signal* signal{ nullptr };
   std::string clock_name;
+  ego_clock::EgoClock2Tick last_tick;
+  std::unique_ptr<EgoClockTickLogWriter> tick_log;
 };
 
-//-------------------------------------------------------------------------------------------------
-EgoClock2Driver::Impl::Impl(const Config& config, realtime::SharedMemory&& shm_in)
-  : shm(std::move(shm_in)), clock_name(config.clock_name) {
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-  signal = reinterpret_cast<ego_clock::EgoClock2Signal*>(shm.data().data());
-  // Initialise the signal in the shared memory region
-  new (signal) ego_clock::EgoClock2Signal{};
-}
-
 //-------------------------------------------------------------------------------------------------
 EgoClock2Driver::Impl::~Impl() {
-  shm.close();
+  if (signal == nullptr) {
+    return;  // construction failed
+  }
+  if (registry != nullptr) {
+    registry->release(signal);
+    return;
+  }
+  shm->close();
   std::ignore = realtime::SharedMemory::remove(clock_name);
 }
 
 //-------------------------------------------------------------------------------------------------
-EgoClock2Driver::EgoClock2Driver(const Config& config) {
+EgoClock2Driver::EgoClock2Driver(const Config& config) : impl_(std::make_unique<Impl>()) {
   using Shm = realtime::SharedMemory;
+  impl_->clock_name = config.clock_name;
+  if (not config.tick_log.empty()) {
+    impl_->tick_log = std::make_unique<EgoClockTickLogWriter>(config.tick_log);
+  }
+  const auto bucket_width = std::max(EgoClock2::Duration{ 1 }, config.wake_resolution).count();
+
+  if (not config.registry_name.empty()) {
+    impl_->shm = ego_clock::mapRegistry(config.registry_name, true);
+    if (impl_->shm == nullptr) {
+      throw std::runtime_error("EgoClock2Driver: Failed to map clock registry '" +
+                               config.registry_name + "'");
+    }
+    auto* registry = ego_clock::registryIn(*impl_->shm);
+    impl_->signal = registry->claim(config.clock_name, bucket_width);
+    if (impl_->signal == nullptr) {
+      throw std::runtime_error("EgoClock2Driver: No free slot for clock '" + config.clock_name +
+                               "' in registry '" + config.registry_name +
+                               "', or another driver is running it");
+    }
+    impl_->registry = registry;
+    return;
+  }
 
   // Remove any stale shared memory from a previous session before creating a new one
   std::ignore = Shm::remove(config.clock_name);
@@ -48,7 +76,12 @@ EgoClock2Driver::EgoClock2Driver(const Config& config) {
     throw std::runtime_error("EgoClock2Driver: Failed to create shared memory '" +
                              config.clock_name + "': " + std::string(maybe_shm.error().message()));
   }
-  impl_ = std::make_unique<Impl>(config, std::move(maybe_shm.value()));
+  impl_->shm = std::make_shared<Shm>(std::move(maybe_shm.value()));
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  impl_->signal = reinterpret_cast<ego_clock::EgoClock2Signal*>(impl_->shm->data().data());
+  // Initialise the signal in the shared memory region
+  new (impl_->signal) ego_clock::EgoClock2Signal{};
+  impl_->signal->bucket_width = bucket_width;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -56,7 +89,32 @@ EgoClock2Driver::~EgoClock2Driver() = default;
 
 //-------------------------------------------------------------------------------------------------
 void EgoClock2Driver::tick(const EgoClock2::TimePoint& ego_time) {
-  impl_->signal->post(EgoClock2::toNanos(ego_time));
+  // Weight of the latest tick interval in the rate estimate. Smooths out scheduling jitter in the
+  // caller's tick loop while still following changes of rate (e.g. simulation speed) within a few
+  // ticks
+  static constexpr auto RATE_SMOOTHING = 0.25;
+
+  const auto wall_nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+  const auto ego_nanos = EgoClock2::toNanos(ego_time);
+  if (impl_->tick_log) {
+    impl_->tick_log->append({ .ego_nanos = ego_nanos, .wall_nanos = wall_nanos });
+  }
+  const auto& last = impl_->last_tick;
+  auto next = ego_clock::EgoClock2Tick{ .ego_nanos = ego_nanos, .wall_nanos = wall_nanos };
+
+  const auto ego_step = ego_nanos - last.ego_nanos;
+  const auto wall_step = wall_nanos - last.wall_nanos;
+  if ((last.wall_nanos != 0) and (ego_step > 0) and (wall_step > 0)) {
+    const auto rate = static_cast<double>(ego_step) / static_cast<double>(wall_step);
+    next.step_nanos = ego_step;
+    next.rate = (last.rate > 0.) ? std::lerp(last.rate, rate, RATE_SMOOTHING) : rate;
+  }
+  // Otherwise this is the first tick or time was reset: no rate until the next tick
+
+  impl_->signal->post(next);
+  impl_->last_tick = next;
 }
 
 }  // namespace grape
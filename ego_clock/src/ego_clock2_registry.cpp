@@ -0,0 +1,53 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#include "ego_clock2_registry.h"
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "grape/realtime/shared_memory.h"
+
+namespace grape::ego_clock {
+
+//-------------------------------------------------------------------------------------------------
+auto mapRegistry(const std::string& registry_name, bool create)
+    -> std::shared_ptr<realtime::SharedMemory> {
+  using Shm = realtime::SharedMemory;
+
+  static auto mutex = std::mutex{};
+  static auto mappings = std::map<std::string, std::weak_ptr<Shm>>{};
+
+  const auto lock = std::lock_guard(mutex);
+  auto& cached = mappings[registry_name];
+  if (auto shm = cached.lock()) {
+    return shm;
+  }
+
+  const auto access = Shm::Access::ReadWrite;
+  auto maybe_shm = Shm::open(registry_name, access);
+  if (not maybe_shm and create) {
+    // Created zero-filled, which is an empty registry
+    maybe_shm = Shm::create(registry_name, sizeof(EgoClock2Registry), access);
+    if (not maybe_shm) {
+      maybe_shm = Shm::open(registry_name, access);  // created by another driver meanwhile
+    }
+  }
+  if (not maybe_shm or (maybe_shm.value().data().size() < sizeof(EgoClock2Registry))) {
+    return nullptr;
+  }
+
+  auto shm = std::make_shared<Shm>(std::move(maybe_shm.value()));
+  cached = shm;
+  return shm;
+}
+
+//-------------------------------------------------------------------------------------------------
+auto registryIn(realtime::SharedMemory& shm) -> EgoClock2Registry* {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return reinterpret_cast<EgoClock2Registry*>(shm.data().data());
+}
+
+}  // namespace grape::ego_clock
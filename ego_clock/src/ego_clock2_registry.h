@@ -0,0 +1,208 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "ego_clock2_signal.h"
+#include "seqlock.h"
+
+namespace grape::realtime {
+class SharedMemory;
+}
+
+namespace grape::ego_clock {
+
+//=================================================================================================
+/// Shared memory layout for many EgoClock2 clocks in one segment
+///
+/// Each clock occupies a cache-line aligned slot holding its name and its EgoClock2Signal, so a
+/// host running dozens of clocks maps one segment instead of one per clock. A segment of zeros is a
+/// valid, empty registry, so whoever creates the segment doesn't need to initialise it.
+///
+/// Slots are claimed by drivers with a compare-and-swap on the slot owner (state and pid), which
+/// also makes the claiming driver the only writer of the slot name. Clocks find a slot by name
+/// without writing. They only write to the waiter counts of its signal, while sleeping on it.
+///
+/// A driver that crashes leaves its slot claimed. A driver restarting with the same name takes over
+/// its slot, and once no slot is free, a claim takes over the slot of any driver, provided its pid
+/// no longer exists, as checked with kill(pid, 0). A dead driver whose pid was reused is not
+/// detected. A slot is never taken from a live driver, and only its driver can release it.
+struct EgoClock2Registry {
+  static constexpr auto NUM_SLOTS = 64U;
+  static constexpr auto MAX_NAME_LENGTH = 63U;
+
+  enum class SlotState : std::uint32_t { Free = 0U, Claimed, Ready };
+
+  /// Slot state, with the pid of the driver that claimed it (0 if free)
+  struct SlotOwner {
+    SlotState state{ SlotState::Free };
+    pid_t pid{ 0 };
+  };
+  static_assert(std::atomic<SlotOwner>::is_always_lock_free, "shared between processes");
+
+  struct SlotName {
+    std::array<char, MAX_NAME_LENGTH + 1> chars{};
+  };
+
+  struct Slot {
+    std::atomic<SlotOwner> owner{};
+    std::atomic<std::uint32_t> incarnation{ 0U };  //!< Bumped by every claim (see EgoClock2)
+    SeqLock<SlotName> name;
+    EgoClock2Signal signal;
+  };
+
+  std::array<Slot, NUM_SLOTS> slots{};
+
+  /// @return Signal of the clock registered as 'clock_name', or nullptr if there is none
+  [[nodiscard]] auto find(std::string_view clock_name) const -> const EgoClock2Signal*;
+
+  /// @return Slot of the clock registered as 'clock_name', or nullptr if there is none
+  [[nodiscard]] auto findSlot(std::string_view clock_name) const -> const Slot*;
+
+  /// @return Whether a slot holds the clock registered as 'clock_name'
+  [[nodiscard]] static auto isRegistered(const Slot& slot, std::string_view clock_name) -> bool;
+
+  /// Claim a slot for a clock and initialise its signal. Takes over a slot already registered with
+  /// the same name, left behind by a driver from a previous session that died, else a free slot,
+  /// else the slot of any driver that died
+  /// @return The signal of the claimed slot, or nullptr if the name is too long, a live driver
+  /// already has the name, or all slots are in use by live drivers
+  [[nodiscard]] auto claim(std::string_view clock_name, std::int64_t bucket_width)
+      -> EgoClock2Signal*;
+
+  /// Return a slot claimed with claim() by this process to the free list. Does nothing if the slot
+  /// has been taken over since
+  void release(const EgoClock2Signal* signal);
+
+private:
+  [[nodiscard]] static auto hasName(const Slot& slot, std::string_view clock_name) -> bool;
+  [[nodiscard]] static auto tryClaim(Slot& slot, SlotOwner expected) -> bool;
+  [[nodiscard]] static auto isAlive(pid_t pid) -> bool;
+};
+
+//-------------------------------------------------------------------------------------------------
+/// Map a registry segment, writable: clocks write the waiter counts of the signals they sleep on.
+/// Clocks and drivers of a process that use the same registry share one mapping, unmapped when the
+/// last of them is destroyed
+/// @param registry_name Shared memory name of the registry (must start with '/')
+/// @param create Create the segment if it doesn't exist yet, as drivers do
+/// @return The mapping, or nullptr if the segment doesn't exist (or can't be created) or is too
+/// small to be a registry
+[[nodiscard]] auto mapRegistry(const std::string& registry_name, bool create)
+    -> std::shared_ptr<realtime::SharedMemory>;
+
+//-------------------------------------------------------------------------------------------------
+/// @return The registry in a mapping returned by mapRegistry()
+[[nodiscard]] auto registryIn(realtime::SharedMemory& shm) -> EgoClock2Registry*;
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Registry::hasName(const Slot& slot, std::string_view clock_name) -> bool {
+  const auto name = slot.name.load();
+  return std::string_view(name.chars.data()) == clock_name;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Registry::tryClaim(Slot& slot, SlotOwner expected) -> bool {
+  const auto claimed = SlotOwner{ .state = SlotState::Claimed, .pid = getpid() };
+  return slot.owner.compare_exchange_strong(expected, claimed, std::memory_order_acquire);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Registry::isAlive(pid_t pid) -> bool {
+  return (pid <= 0) or (kill(pid, 0) == 0) or (errno != ESRCH);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Registry::isRegistered(const Slot& slot, std::string_view clock_name)
+    -> bool {
+  return (slot.owner.load(std::memory_order_acquire).state == SlotState::Ready) and
+         hasName(slot, clock_name);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Registry::findSlot(std::string_view clock_name) const -> const Slot* {
+  const auto it = std::ranges::find_if(
+      slots, [clock_name](const Slot& slot) { return isRegistered(slot, clock_name); });
+  return (it == slots.end()) ? nullptr : &*it;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Registry::find(std::string_view clock_name) const -> const EgoClock2Signal* {
+  const auto* slot = findSlot(clock_name);
+  return (slot == nullptr) ? nullptr : &slot->signal;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Registry::claim(std::string_view clock_name, std::int64_t bucket_width)
+    -> EgoClock2Signal* {
+  if (clock_name.empty() or clock_name.size() > MAX_NAME_LENGTH) {
+    return nullptr;
+  }
+
+  // Prefer the slot of a previous session with the same name, so that clocks waiting on it carry
+  // on. Fail if that session is still running, rather than have two drivers post to one signal
+  auto it = std::ranges::find_if(
+      slots, [clock_name](const Slot& slot) { return isRegistered(slot, clock_name); });
+  if (it != slots.end()) {
+    const auto owner = it->owner.load(std::memory_order_acquire);
+    if ((owner.state != SlotState::Ready) or isAlive(owner.pid) or not tryClaim(*it, owner)) {
+      return nullptr;
+    }
+  } else {
+    it = std::ranges::find_if(slots, [](Slot& slot) { return tryClaim(slot, SlotOwner{}); });
+  }
+  if (it == slots.end()) {
+    // Ready or still being claimed by a driver that crashed. The compare-and-swap on the pid lets
+    // only one of the drivers that find it dead take it over
+    it = std::ranges::find_if(slots, [](Slot& slot) {
+      const auto owner = slot.owner.load(std::memory_order_acquire);
+      return (owner.state != SlotState::Free) and not isAlive(owner.pid) and
+             tryClaim(slot, owner);
+    });
+  }
+  if (it == slots.end()) {
+    return nullptr;
+  }
+
+  // Bumped before anything else changes, so that a clock that sees any of the changes below also
+  // sees the slot was reused
+  it->incarnation.fetch_add(1U, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  auto name = SlotName{};
+  std::ranges::copy(clock_name, name.chars.begin());
+  it->name.store(name);
+  // Reinitialise in place: clocks of a previous session may still be reading it
+  it->signal.nanos.store(0, std::memory_order_relaxed);
+  it->signal.tick.store({});
+  it->signal.bucket_width.store(bucket_width, std::memory_order_relaxed);
+  it->owner.store({ .state = SlotState::Ready, .pid = getpid() }, std::memory_order_release);
+  return &it->signal;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void EgoClock2Registry::release(const EgoClock2Signal* signal) {
+  const auto it = std::ranges::find_if(slots, [signal](const Slot& slot) {
+    return &slot.signal == signal;
+  });
+  if (it != slots.end()) {
+    // Only if still ours: a driver that found this process dead may have taken it over
+    auto owner = SlotOwner{ .state = SlotState::Ready, .pid = getpid() };
+    it->owner.compare_exchange_strong(owner, SlotOwner{}, std::memory_order_release);
+  }
+}
+
+}  // namespace grape::ego_clock
@@ -0,0 +1,72 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#include "grape/ego_clock2_replay_driver.h"
+
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "grape/ego_clock_tick_log.h"
+
+namespace grape {
+
+//-------------------------------------------------------------------------------------------------
+struct EgoClock2ReplayDriver::Impl {
+  explicit Impl(const Config& config);
+  static auto driverConfig(const Config& config) -> EgoClock2Driver::Config;
+  EgoClockTickLogReader reader;
+  EgoClock2Driver driver;
+  double speed{ 0. };
+};
+
+//-------------------------------------------------------------------------------------------------
+EgoClock2ReplayDriver::Impl::Impl(const Config& config)
+  : reader(config.tick_log), driver(driverConfig(config)), speed(config.speed) {
+}
+
+//-------------------------------------------------------------------------------------------------
+auto EgoClock2ReplayDriver::Impl::driverConfig(const Config& config) -> EgoClock2Driver::Config {
+  auto driver_config = config.driver;
+  driver_config.tick_log.clear();  // don't record the replay, least of all over the log replayed
+  return driver_config;
+}
+
+//-------------------------------------------------------------------------------------------------
+EgoClock2ReplayDriver::EgoClock2ReplayDriver(const Config& config)
+  : impl_(std::make_unique<Impl>(config)) {
+}
+
+//-------------------------------------------------------------------------------------------------
+EgoClock2ReplayDriver::~EgoClock2ReplayDriver() = default;
+
+//-------------------------------------------------------------------------------------------------
+auto EgoClock2ReplayDriver::run(const std::stop_token& stop_token) -> std::size_t {
+  using Clock = std::chrono::steady_clock;
+  const auto is_paced = (impl_->speed > 0.);
+
+  // Recorded wall time of the first tick of this run, and when it was posted
+  auto origin = std::optional<std::pair<std::int64_t, Clock::time_point>>{};
+  auto num_ticks = std::size_t{ 0U };
+  while (not stop_token.stop_requested()) {
+    const auto tick = impl_->reader.next();
+    if (not tick) {
+      break;
+    }
+    if (is_paced) {
+      if (not origin) {
+        origin = { tick->wall_nanos, Clock::now() };
+      }
+      const auto recorded_ns = static_cast<double>(tick->wall_nanos - origin->first);
+      const auto delay_ns = static_cast<std::int64_t>(recorded_ns / impl_->speed);
+      std::this_thread::sleep_until(origin->second + std::chrono::nanoseconds(delay_ns));
+    }
+    impl_->driver.tick(EgoClock2::fromNanos(tick->ego_nanos));
+    ++num_ticks;
+  }
+  return num_ticks;
+}
+
+}  // namespace grape
@@ -4,37 +4,114 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <climits>
 #include <ctime>
+#include <limits>
 #include <system_error>
 
 #include <linux/futex.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 
+#include "seqlock.h"
+
 namespace grape::ego_clock {
 
+//=================================================================================================
+/// A posted tick, with what readers need to interpolate ego time until the next one
+struct EgoClock2Tick {
+  std::int64_t ego_nanos{ 0 };   //!< Ego clock time of the tick
+  std::int64_t wall_nanos{ 0 };  //!< CLOCK_MONOTONIC time at which the tick was posted
+  std::int64_t step_nanos{ 0 };  //!< Ego time between the previous tick and this one
+  double rate{ 0. };             //!< Estimated ego ns per monotonic ns. 0 if not known yet
+  std::int64_t floor_nanos{ 0 };  //!< Latest ego time readers could reach from earlier ticks
+};
+
+//-------------------------------------------------------------------------------------------------
+/// @return Ego time interpolated from a tick to monotonic time 'wall_nanos'. Never earlier than the
+/// tick or than earlier ticks let readers get to (floor_nanos), and never later than one tick step
+/// past it, so that readers stay monotonic across ticks, even as steps shrink, and don't run ahead
+/// if the driver pauses
+constexpr auto interpolate(const EgoClock2Tick& tick, std::int64_t wall_nanos) -> std::int64_t {
+  const auto elapsed = static_cast<double>(wall_nanos - tick.wall_nanos);
+  auto advance = 0.;
+  if ((tick.rate > 0.) and (elapsed > 0.)) {
+    advance = std::min(tick.rate * elapsed, static_cast<double>(tick.step_nanos));
+  }
+  return std::max(tick.floor_nanos, tick.ego_nanos + static_cast<std::int64_t>(advance));
+}
+
 //=================================================================================================
 // Shared memory layout for EgoClock2 futex-based synchronization
+//
+// Sleepers are spread over a ring of futex words (a hashed timing wheel), by deadline. A tick only
+// wakes the buckets of deadlines it has reached, rather than every sleeper, so a sleeper is
+// normally woken once, at its deadline. Sleepers count themselves in the bucket while they wait,
+// so that a tick skips the buckets nobody waits in, and makes no system call at all when there are
+// no sleepers. A deadline a whole number of wheel revolutions away shares a bucket with nearer
+// ones, and is woken once per revolution to re-check.
 struct EgoClock2Signal {
+  static constexpr auto NUM_WAKE_BUCKETS = 64U;
+  static constexpr auto CACHE_LINE_SIZE = 64U;
+
+  /// Futex word for sleepers with deadlines in one bucket. Bumped each time a tick reaches them
+  struct alignas(CACHE_LINE_SIZE) WakeBucket {
+    std::atomic<std::uint32_t> generation{ 0U };
+    mutable std::atomic<std::uint32_t> waiters{ 0U };  //!< Sleepers waiting on generation
+  };
+
   alignas(std::int64_t) std::atomic<std::int64_t> nanos{ 0 };
+  std::atomic<std::uint32_t> generation{ 0U };  //!< Futex word, bumped with every post
+  mutable std::atomic<std::uint32_t> num_waiters{ 0U };  //!< Waiting on generation in wait()
+  std::atomic<std::int64_t> bucket_width{ 1 };  //!< Ego nanoseconds of deadlines per bucket
+  SeqLock<EgoClock2Tick> tick;     //!< Latest tick with timing, for interpolation between ticks
+  std::array<WakeBucket, NUM_WAKE_BUCKETS> buckets{};
+
   [[nodiscard]] auto get() const -> std::int64_t;
-  void post(std::int64_t value);
+  [[nodiscard]] auto getTick() const -> EgoClock2Tick;
+  void post(const EgoClock2Tick& value);
   [[nodiscard]] auto wait(std::int64_t expected, std::chrono::milliseconds timeout) const -> bool;
+  [[nodiscard]] auto waitUntil(std::int64_t deadline, std::chrono::milliseconds timeout) const
+      -> bool;
+
+private:
+  [[nodiscard]] auto bucketIndex(std::int64_t ego_nanos) const -> std::int64_t;
+  [[nodiscard]] auto bucket(std::int64_t index) const -> const WakeBucket&;
+  [[nodiscard]] auto bucket(std::int64_t index) -> WakeBucket&;
 };
 
-//-------------------------------------------------------------------------------------------------
-inline auto EgoClock2Signal::get() const -> std::int64_t {
-  return nanos.load(std::memory_order_acquire);
-}
+//=================================================================================================
+/// Counts a sleeper in a waiter count while it is in scope. Waiter counts are written by clocks,
+/// so they map the segment writable. A sleeper killed while waiting leaves its count behind, which
+/// only costs the ticks to its bucket a spare wake-up call
+class WaiterCount {
+public:
+  explicit WaiterCount(std::atomic<std::uint32_t>& waiters) : waiters_(&waiters) {
+    waiters_->fetch_add(1U, std::memory_order_relaxed);
+    // Counted before the caller reads the time. post() stores the time before it reads the count,
+    // so either the caller sees the new time, or post() sees the caller and wakes it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+  ~WaiterCount() {
+    waiters_->fetch_sub(1U, std::memory_order_relaxed);
+  }
+  WaiterCount(const WaiterCount&) = delete;
+  WaiterCount(WaiterCount&&) = delete;
+  auto operator=(const WaiterCount&) = delete;
+  auto operator=(WaiterCount&&) = delete;
+
+private:
+  std::atomic<std::uint32_t>* waiters_;
+};
 
 //-------------------------------------------------------------------------------------------------
-inline void EgoClock2Signal::post(std::int64_t value) {
-  nanos.store(value, std::memory_order_release);
+inline void futexWake(const void* addr) {
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-  const auto result = syscall(SYS_futex, &nanos, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+  const auto result = syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
   if (result == -1) {
     const auto err = std::error_code(errno, std::system_category());
     throw std::runtime_error("(futex_wake) " + err.message());
@@ -42,17 +119,16 @@ inline void EgoClock2Signal::post(std::int64_t value) {
 }
 
 //-------------------------------------------------------------------------------------------------
-inline auto EgoClock2Signal::wait(std::int64_t expected, std::chrono::milliseconds timeout) const
+/// @return true if woken or the 32-bit word at addr no longer holds 'expected', false on timeout
+/// or interruption
+inline auto futexWait(const void* addr, std::uint32_t expected, std::chrono::milliseconds timeout)
     -> bool {
   const auto sec = std::chrono::duration_cast<std::chrono::seconds>(timeout);
   const auto nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - sec);
   const auto ts = timespec{ .tv_sec = sec.count(), .tv_nsec = nsec.count() };
 
-  // Futex operates on 32-bit values and we use it only to detect change
-  const auto ex = static_cast<std::uint32_t>(expected);
-
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-  const auto result = syscall(SYS_futex, &nanos, FUTEX_WAIT, ex, &ts, nullptr, 0);
+  const auto result = syscall(SYS_futex, addr, FUTEX_WAIT, expected, &ts, nullptr, 0);
   if (result == -1) {
     const auto err = std::error_code(errno, std::system_category());
     if (err.value() == ETIMEDOUT) {
@@ -69,4 +145,97 @@ inline auto EgoClock2Signal::wait(std::int64_t expected, std::chrono::millisecon
   return true;
 }
 
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Signal::get() const -> std::int64_t {
+  return nanos.load(std::memory_order_acquire);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Signal::getTick() const -> EgoClock2Tick {
+  return tick.load();
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Signal::bucketIndex(std::int64_t ego_nanos) const -> std::int64_t {
+  return ego_nanos / bucket_width.load(std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Signal::bucket(std::int64_t index) const -> const WakeBucket& {
+  return buckets.at(static_cast<std::uint64_t>(index) % NUM_WAKE_BUCKETS);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Signal::bucket(std::int64_t index) -> WakeBucket& {
+  return buckets.at(static_cast<std::uint64_t>(index) % NUM_WAKE_BUCKETS);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void EgoClock2Signal::post(const EgoClock2Tick& value) {
+  const auto previous = nanos.load(std::memory_order_relaxed);
+
+  // Readers may have interpolated as far as the previous tick's step past it, which is beyond this
+  // tick if the step shrank: hold them there until this tick catches up. Not if time went back
+  const auto last_tick = tick.load();
+  auto next = value;
+  if (value.ego_nanos >= last_tick.ego_nanos) {
+    const auto reachable = interpolate(last_tick, std::numeric_limits<std::int64_t>::max());
+    next.floor_nanos = std::max(value.floor_nanos, reachable);
+  }
+  tick.store(next);
+  nanos.store(value.ego_nanos, std::memory_order_release);
+  generation.fetch_add(1U, std::memory_order_release);
+  // Time stored before the waiter counts are read (see WaiterCount)
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (num_waiters.load(std::memory_order_relaxed) != 0U) {
+    futexWake(&generation);
+  }
+
+  // Wake the buckets from the one holding the previous tick (its later deadlines may be due now) up
+  // to the one holding this tick. Every bucket if the clock jumped back or by a whole revolution
+  auto first = bucketIndex(previous);
+  const auto last = bucketIndex(value.ego_nanos);
+  if ((last < first) or (last - first >= NUM_WAKE_BUCKETS)) {
+    first = last - NUM_WAKE_BUCKETS + 1;
+  }
+  for (auto index = first; index <= last; ++index) {
+    auto& wake_bucket = bucket(index);
+    if (wake_bucket.waiters.load(std::memory_order_relaxed) != 0U) {
+      wake_bucket.generation.fetch_add(1U, std::memory_order_release);
+      futexWake(&wake_bucket.generation);
+    }
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto EgoClock2Signal::wait(std::int64_t expected, std::chrono::milliseconds timeout) const
+    -> bool {
+  // Futex compares only 32 bits, so it can't wait on 'nanos' itself: a post that leaves the low
+  // word unchanged would look like no change, and the wake-up would be lost. Wait on the generation
+  // instead, read before 'nanos' (post() updates them in the opposite order), so a post in between
+  // changes the generation and the futex wait returns at once
+  const auto waiter = WaiterCount(num_waiters);
+  const auto expected_generation = generation.load(std::memory_order_acquire);
+  if (get() != expected) {
+    return true;
+  }
+  return futexWait(&generation, expected_generation, timeout);
+}
+
+//-------------------------------------------------------------------------------------------------
+/// Wait for a tick at or past 'deadline', or for its bucket to be woken by an earlier tick
+/// @return false on timeout or interruption
+inline auto EgoClock2Signal::waitUntil(std::int64_t deadline,
+                                       std::chrono::milliseconds timeout) const -> bool {
+  const auto& wake_bucket = bucket(bucketIndex(deadline));
+  const auto waiter = WaiterCount(wake_bucket.waiters);
+  // Read the generation before the time. post() updates them in the opposite order, so a tick
+  // posted in between changes the generation and the futex wait returns at once
+  const auto expected = wake_bucket.generation.load(std::memory_order_acquire);
+  if (get() >= deadline) {
+    return true;
+  }
+  return futexWait(&wake_bucket.generation, expected, timeout);
+}
+
 }  // namespace grape::ego_clock
@@ -4,7 +4,12 @@
 
 #include "grape/ego_clock_driver.h"
 
+#include <algorithm>
+#include <optional>
+#include <utility>
+
 #include "clock_topic.h"
+#include "grape/ego_clock_tick_log.h"
 #include "grape/ipc/publisher.h"
 #include "grape/log/syslog.h"
 #include "line_fitter.h"
@@ -14,19 +19,26 @@ struct EgoClockDriver::Impl {
   explicit Impl(const Config& config);
   WallClock::Duration broadcast_interval{};
   WallClock::TimePoint last_broadcast_time;
+  std::uint64_t sequence{ 0U };
   ego_clock::ClockTransform last_fit;
   ego_clock::LineFitter line_fitter;
+  std::optional<std::pair<std::int64_t, std::int64_t>> origin_ns;  //!< (ego, wall) at first tick
   ipc::Publisher<ego_clock::ClockTopic> tick_pub;
+  std::unique_ptr<EgoClockTickLogWriter> tick_log;
 };
 
 //-------------------------------------------------------------------------------------------------
 EgoClockDriver::Impl::Impl(const Config& config)
   : broadcast_interval(config.broadcast_interval)
-  , line_fitter(config.calibration_window)
+  , line_fitter(config.calibration_window, config.robust_fit ? ego_clock::LineFitter::Mode::Robust :
+                                                               ego_clock::LineFitter::Mode::Batch)
   , tick_pub(ipc::Publisher(ego_clock::ClockTopic(config.clock_name))) {
   if (config.calibration_window < 2U) {
     panic("Calibration window must be at least 2 ticks");
   }
+  if (not config.tick_log.empty()) {
+    tick_log = std::make_unique<EgoClockTickLogWriter>(config.tick_log);
+  }
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -36,14 +48,35 @@ EgoClockDriver::EgoClockDriver(const Config& config) : impl_(std::make_unique<Im
 //-------------------------------------------------------------------------------------------------
 EgoClockDriver::~EgoClockDriver() = default;
 
+//-------------------------------------------------------------------------------------------------
+auto EgoClockDriver::sequence() const -> std::uint64_t {
+  return impl_->sequence;
+}
+
 //-------------------------------------------------------------------------------------------------
 void EgoClockDriver::tick(const EgoClock::TimePoint& ego_time,
                           const WallClock::TimePoint& wall_time) {
-  impl_->line_fitter.add({ .x = static_cast<double>(EgoClock::toNanos(ego_time)),
-                           .y = static_cast<double>(WallClock::toNanos(wall_time)) });
+  // Fit relative to the first tick. Integer nanoseconds since epoch (~1e18) don't fit in a double
+  // exactly, but nanoseconds since the first tick do for over 100 days
+  const auto ego_ns = EgoClock::toNanos(ego_time);
+  const auto wall_ns = WallClock::toNanos(wall_time);
+  if (impl_->tick_log) {
+    impl_->tick_log->append({ .ego_nanos = ego_ns, .wall_nanos = wall_ns });
+  }
+  if (not impl_->origin_ns) {
+    impl_->origin_ns = { ego_ns, wall_ns };
+  }
+  const auto [ego_origin_ns, wall_origin_ns] = *impl_->origin_ns;
+  impl_->line_fitter.add({ .x = static_cast<double>(ego_ns - ego_origin_ns),
+                           .y = static_cast<double>(wall_ns - wall_origin_ns) });
   if (wall_time < impl_->last_broadcast_time + impl_->broadcast_interval) {
     return;
   }
+  // Ticks may be further apart than the broadcast interval, and then so are broadcasts
+  const auto broadcast_period =
+      (impl_->sequence == 0U) ?
+          impl_->broadcast_interval :
+          std::max(impl_->broadcast_interval, wall_time - impl_->last_broadcast_time);
   impl_->last_broadcast_time = wall_time;
 
   const auto fit = impl_->line_fitter.fit();
@@ -52,9 +85,19 @@ void EgoClockDriver::tick(const EgoClock::TimePoint& ego_time,
     return;
   }
 
-  const auto tf = ego_clock::ClockTransform{ .scale = fit->slope,
-                                             .offset = fit->intercept,
-                                             .rmse = std::round(std::sqrt(fit->mse)) };
+  // Published relative to the first tick too, so that receivers keep the precision of the fit
+  // Receivers consider the transform stale if they miss a few broadcasts in a row
+  static constexpr auto VALIDITY_BROADCASTS = 3;
+  const auto tf = ego_clock::ClockTransform{
+    .ego_origin_ns = ego_origin_ns,
+    .wall_origin_ns = wall_origin_ns,
+    .scale = fit->slope,
+    .offset = fit->intercept,
+    .rmse = std::round(std::sqrt(fit->mse)),
+    .sequence = ++impl_->sequence,
+    .fit_time = wall_time,
+    .valid_until = wall_time + (VALIDITY_BROADCASTS * broadcast_period),
+  };
   if (not impl_->tick_pub.publish(tf)) {
     syslog::Error("Failed to publish clock tick");
   }
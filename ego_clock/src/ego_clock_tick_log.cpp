@@ -0,0 +1,186 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#include "grape/ego_clock_tick_log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "grape/log/syslog.h"
+#include "tick_log_format.h"
+
+namespace grape {
+
+namespace {
+using ego_clock::TickLogFormat;
+
+//-------------------------------------------------------------------------------------------------
+auto fileError(const std::string& what, const std::string& path) -> std::runtime_error {
+  return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+}
+
+//-------------------------------------------------------------------------------------------------
+auto isTickLog(std::span<const std::byte> data) -> bool {
+  auto header = TickLogFormat::Header{};
+  if (data.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  return (header.magic == TickLogFormat::MAGIC) and (header.version == TickLogFormat::VERSION);
+}
+
+//-------------------------------------------------------------------------------------------------
+void writeAll(int fd, std::span<const std::byte> data, const std::string& path) {
+  while (not data.empty()) {
+    const auto written = ::write(fd, data.data(), data.size());
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw fileError("EgoClockTickLogWriter: Failed to write", path);
+    }
+    data = data.subspan(static_cast<std::size_t>(written));
+  }
+}
+
+}  // namespace
+
+//-------------------------------------------------------------------------------------------------
+EgoClockTickLogWriter::EgoClockTickLogWriter(const std::string& path) : path_(path) {
+  buffer_.reserve(BUFFER_SIZE + TickLogFormat::MAX_RECORD_BYTES);
+
+  // Scan an existing log for the last tick, to carry on the deltas from, and for the end of the
+  // last complete record, to drop anything after it
+  struct stat st{};
+  const auto exists = (::stat(path.c_str(), &st) == 0) and (st.st_size > 0);
+  auto end = sizeof(TickLogFormat::Header);
+  if (exists) {
+    auto reader = EgoClockTickLogReader(path);
+    while (const auto tick = reader.next()) {
+      last_ = *tick;
+    }
+    end = reader.offset();
+  }
+
+  static constexpr auto MODE = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, MODE);
+  if (fd_ < 0) {
+    throw fileError("EgoClockTickLogWriter: Failed to open", path);
+  }
+  if (not exists) {
+    const auto header = TickLogFormat::Header{};
+    writeAll(fd_, std::as_bytes(std::span(&header, 1U)), path);
+  }
+  if ((::ftruncate(fd_, static_cast<off_t>(end)) != 0) or
+      (::lseek(fd_, static_cast<off_t>(end), SEEK_SET) < 0)) {
+    const auto error = fileError("EgoClockTickLogWriter: Failed to seek to the end of", path);
+    ::close(fd_);
+    throw error;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+EgoClockTickLogWriter::~EgoClockTickLogWriter() {
+  try {
+    flush();
+  } catch (const std::exception& ex) {
+    syslog::Error("{}", ex.what());
+  }
+  ::close(fd_);
+}
+
+//-------------------------------------------------------------------------------------------------
+void EgoClockTickLogWriter::append(const EgoClockTick& tick) {
+  const auto size = buffer_.size();
+  buffer_.resize(size + TickLogFormat::MAX_RECORD_BYTES);
+  auto out = std::span(buffer_).subspan(size);
+  const auto ego_bytes = ego_clock::encodeVarint(
+      ego_clock::zigzagEncode(tick.ego_nanos - last_.ego_nanos), out);
+  const auto wall_bytes = ego_clock::encodeVarint(
+      ego_clock::zigzagEncode(tick.wall_nanos - last_.wall_nanos), out.subspan(ego_bytes));
+  buffer_.resize(size + ego_bytes + wall_bytes);
+  last_ = tick;
+  if (buffer_.size() >= BUFFER_SIZE) {
+    flush();
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+void EgoClockTickLogWriter::flush() {
+  // Clear first, so that a failed write isn't retried (and duplicated) by the destructor
+  const auto data = std::move(buffer_);
+  buffer_.clear();
+  buffer_.reserve(BUFFER_SIZE + TickLogFormat::MAX_RECORD_BYTES);
+  writeAll(fd_, data, path_);
+}
+
+//-------------------------------------------------------------------------------------------------
+EgoClockTickLogReader::EgoClockTickLogReader(const std::string& path) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+  const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw fileError("EgoClockTickLogReader: Failed to open", path);
+  }
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    const auto error = fileError("EgoClockTickLogReader: Failed to stat", path);
+    ::close(fd);
+    throw error;
+  }
+  const auto size = static_cast<std::size_t>(st.st_size);
+  if (size < sizeof(TickLogFormat::Header)) {
+    ::close(fd);
+    throw std::runtime_error("EgoClockTickLogReader: '" + path + "' is not a tick log");
+  }
+  auto* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);  // the mapping stays valid
+  if (addr == MAP_FAILED) {
+    throw fileError("EgoClockTickLogReader: Failed to map", path);
+  }
+  data_ = std::span(static_cast<const std::byte*>(addr), size);
+  if (not isTickLog(data_)) {
+    ::munmap(addr, size);
+    throw std::runtime_error("EgoClockTickLogReader: '" + path + "' is not a tick log");
+  }
+  ::madvise(addr, size, MADV_SEQUENTIAL);
+  rewind();
+}
+
+//-------------------------------------------------------------------------------------------------
+EgoClockTickLogReader::~EgoClockTickLogReader() {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  ::munmap(const_cast<std::byte*>(data_.data()), data_.size());
+}
+
+//-------------------------------------------------------------------------------------------------
+auto EgoClockTickLogReader::next() -> std::optional<EgoClockTick> {
+  const auto in = data_.subspan(offset_);
+  const auto ego = ego_clock::decodeVarint(in);
+  if (not ego) {
+    return std::nullopt;
+  }
+  const auto wall = ego_clock::decodeVarint(in.subspan(ego->second));
+  if (not wall) {
+    return std::nullopt;  // end of log, or a record cut short
+  }
+  offset_ += ego->second + wall->second;
+  last_ = { .ego_nanos = last_.ego_nanos + ego_clock::zigzagDecode(ego->first),
+            .wall_nanos = last_.wall_nanos + ego_clock::zigzagDecode(wall->first) };
+  return last_;
+}
+
+//-------------------------------------------------------------------------------------------------
+void EgoClockTickLogReader::rewind() {
+  offset_ = sizeof(ego_clock::TickLogFormat::Header);
+  last_ = {};
+}
+
+}  // namespace grape
@@ -4,10 +4,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cinttypes>
 #include <cmath>
+#include <limits>
 #include <numeric>
 #include <optional>
+#include <span>
 #include <vector>
 
 #include "grape/exception.h"
@@ -19,6 +22,15 @@ namespace grape::ego_clock {
 ///
 class LineFitter {
 public:
+  /// How the fit is computed over the sliding window
+  enum class Mode : std::uint8_t {
+    Batch,       //!< fit() rescans the window. O(window_size) per fit
+    Incremental,  //!< add() updates running sums, fit() is O(1). mse has a resolution of about
+                  //!< 1e-8 of the span of y over the window
+    Robust  //!< Least squares with Huber loss, solved by iteratively reweighted least squares.
+            //!< Outliers get less weight. O(window_size) per iteration, a few iterations per fit
+  };
+
   /// A single data point
   struct DataPoint {
     double x{};
@@ -29,43 +41,288 @@ public:
   struct FitParams {
     double slope{};
     double intercept{};
-    double mse{};  //!< Mean Squared Error - measure of fit quality (lower is better)
+    double mse{};  //!< Mean Squared Error - measure of fit quality (lower is better). In robust
+                   //!< mode, over the samples not down-weighted as outliers
   };
 
   /// Constructor
   /// @param window_size Number of samples in the sliding window (must be > 1)
-  explicit LineFitter(std::size_t window_size);
+  /// @param mode Selects how the fit is computed
+  explicit LineFitter(std::size_t window_size, Mode mode = Mode::Batch);
 
   /// Add a data point to the sample set
   void add(const DataPoint& data);
 
   /// Process the current sample set and compute the fit parameters
+  /// @note In robust mode, uses internal scratch space. Don't call from multiple threads
   /// @return Fit parameters if enough samples are available
   [[nodiscard]] auto fit() const -> std::optional<FitParams>;
 
 private:
+  /// Sum with Neumaier compensation, so that adding and later subtracting the same values over a
+  /// long run doesn't accumulate rounding error
+  class CompensatedSum {
+  public:
+    void add(double value);
+    [[nodiscard]] auto value() const -> double;
+
+  private:
+    double sum_{};
+    double compensation_{};
+  };
+
+  /// Running sums over the samples in the window, relative to the origin
+  struct RunningSums {
+    CompensatedSum x;
+    CompensatedSum y;
+    CompensatedSum xx;
+    CompensatedSum xy;
+    CompensatedSum yy;
+    void add(const DataPoint& data, double sign);
+  };
+
+  void recentre();
+  [[nodiscard]] auto numSamples() const -> double;
+  [[nodiscard]] auto oldestSample() const -> const DataPoint&;
+  [[nodiscard]] auto fitBatch() const -> std::optional<FitParams>;
+  [[nodiscard]] auto fitIncremental() const -> std::optional<FitParams>;
+  [[nodiscard]] auto fitRobust() const -> std::optional<FitParams>;
+
   std::vector<DataPoint> samples_;
   std::size_t write_index_{ 0U };
+  Mode mode_{ Mode::Batch };
+
+  // Incremental mode only. Sums are taken relative to a sample in the window, moved every time the
+  // window turns over, so that large offsets (e.g. nanoseconds since epoch) and a long uptime don't
+  // swamp the variation within the window
+  DataPoint origin_{};
+  RunningSums sums_{};
+
+  // Robust mode only. Scratch space for residuals, allocated once
+  mutable std::vector<double> residuals_;
 };
 
 //-------------------------------------------------------------------------------------------------
-inline LineFitter::LineFitter(std::size_t window_size) : samples_(window_size) {
+inline void LineFitter::CompensatedSum::add(double value) {
+  const auto total = sum_ + value;
+  if (std::abs(sum_) >= std::abs(value)) {
+    compensation_ += (sum_ - total) + value;
+  } else {
+    compensation_ += (value - total) + sum_;
+  }
+  sum_ = total;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto LineFitter::CompensatedSum::value() const -> double {
+  return sum_ + compensation_;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void LineFitter::RunningSums::add(const DataPoint& data, double sign) {
+  x.add(sign * data.x);
+  y.add(sign * data.y);
+  xx.add(sign * data.x * data.x);
+  xy.add(sign * data.x * data.y);
+  yy.add(sign * data.y * data.y);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline LineFitter::LineFitter(std::size_t window_size, Mode mode)
+  : samples_(window_size), mode_(mode) {
   if (window_size <= 1) {
     panic("LineFitter window_size must be greater than 1");
   }
+  if (mode_ == Mode::Robust) {
+    residuals_.resize(window_size);
+  }
 }
 
 //-------------------------------------------------------------------------------------------------
 inline void LineFitter::add(const DataPoint& data) {
-  samples_.at(write_index_ % samples_.size()) = data;
+  auto& slot = samples_.at(write_index_ % samples_.size());
+  if (mode_ == Mode::Incremental) {
+    if (write_index_ == 0U) {
+      origin_ = data;
+    }
+    if (write_index_ >= samples_.size()) {
+      // evict the oldest sample. Same arithmetic as when it was added, so it cancels exactly
+      sums_.add({ .x = slot.x - origin_.x, .y = slot.y - origin_.y }, -1.);
+    }
+    sums_.add({ .x = data.x - origin_.x, .y = data.y - origin_.y }, 1.);
+  }
+  slot = data;
   write_index_++;
+  if (mode_ == Mode::Incremental and (write_index_ % samples_.size()) == 0U) {
+    recentre();
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void LineFitter::recentre() {
+  // Move the origin to the newest sample and rebuild the sums from scratch. O(window_size), once
+  // every window_size samples
+  origin_ = samples_.back();
+  sums_ = {};
+  for (const auto& sample : samples_) {
+    sums_.add({ .x = sample.x - origin_.x, .y = sample.y - origin_.y }, 1.);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto LineFitter::fit() const -> std::optional<FitParams> {
+  switch (mode_) {
+    case Mode::Incremental:
+      return fitIncremental();
+    case Mode::Robust:
+      return fitRobust();
+    case Mode::Batch:
+      break;
+  }
+  return fitBatch();
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto LineFitter::numSamples() const -> double {
+  const auto buf_size = samples_.size();
+  return static_cast<double>((write_index_ < buf_size) ? write_index_ : buf_size);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto LineFitter::oldestSample() const -> const DataPoint& {
+  return (write_index_ < samples_.size()) ? samples_.front() :
+                                            samples_.at(write_index_ % samples_.size());
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto LineFitter::fitIncremental() const -> std::optional<FitParams> {
+  if (write_index_ < 2U) {
+    return std::nullopt;
+  }
+  const auto num_samples = numSamples();
+
+  // Same normal equations as fitBatch(), from the running sums. The squared error expands to
+  // - n.∑(yᵢ - ŷᵢ)² = (n.∑(yᵢ²) − (∑yᵢ)²) − slope.(n.∑(xᵢ.yᵢ) − ∑xᵢ.∑yᵢ)
+  const auto sum_x = sums_.x.value();
+  const auto sum_y = sums_.y.value();
+  const auto sum_xy_centred = std::fma(sum_x, -sum_y, num_samples * sums_.xy.value());
+  const auto denom = std::fma(sum_x, -sum_x, num_samples * sums_.xx.value());
+  const auto slope = sum_xy_centred / denom;
+  const auto intercept = std::fma(slope, -sum_x, sum_y) / num_samples;
+  const auto sum_yy_centred = std::fma(sum_y, -sum_y, num_samples * sums_.yy.value());
+  const auto sum_error_squared = std::fma(-slope, sum_xy_centred, sum_yy_centred) / num_samples;
+
+  // rounding can leave a tiny negative error on a perfect fit
+  const auto mse = std::max(0., sum_error_squared / num_samples);
+
+  // shift the line back from the origin
+  return FitParams{ .slope = slope,
+                    .intercept = std::fma(-slope, origin_.x, origin_.y) + intercept,
+                    .mse = mse };
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto LineFitter::fitRobust() const -> std::optional<FitParams> {
+  if (write_index_ < 2U) {
+    return std::nullopt;
+  }
+
+  // Minimise ∑ρ(rᵢ), where rᵢ = yᵢ - ŷᵢ and ρ is the Huber loss: quadratic for |rᵢ| <= k.s and
+  // linear beyond. The first iteration is the ordinary least squares fit. Each further iteration
+  // - estimates the scale s of the residuals from their median absolute value, which a minority of
+  //   outliers doesn't inflate,
+  // - weighs each sample by wᵢ = min(1, k.s/|rᵢ|), and
+  // - solves the weighted least squares problem for the next slope and intercept.
+  // Sums are taken relative to the oldest sample, as in the batch fit.
+  static constexpr auto HUBER_K = 1.345;        // 95% efficiency on gaussian noise
+  static constexpr auto MAD_TO_SIGMA = 1.4826;  // median absolute error to sigma, gaussian noise
+  static constexpr auto MAX_ITERATIONS = 8U;
+  static constexpr auto TOLERANCE = 1e-3;  // change in the fit at convergence, relative to k.s
+
+  const auto num_samples = static_cast<std::size_t>(numSamples());
+  const auto window = std::span{ samples_.begin(), num_samples };
+  const auto residuals = std::span{ residuals_.begin(), num_samples };
+  const auto origin = oldestSample();
+  const auto span_x = std::abs(samples_.at((write_index_ - 1U) % samples_.size()).x - origin.x);
+  const auto error = [&origin](const DataPoint& sample, double slope, double intercept) {
+    return (sample.y - origin.y) - std::fma(slope, sample.x - origin.x, intercept);
+  };
+  const auto weight = [](double err, double threshold) {
+    return (std::abs(err) <= threshold) ? 1.0 : threshold / std::abs(err);
+  };
+
+  auto slope = 0.;
+  auto intercept = 0.;
+  auto threshold = std::numeric_limits<double>::infinity();
+  for (auto iteration = 0U; iteration < MAX_ITERATIONS; ++iteration) {
+    if (iteration > 0U) {
+      std::ranges::transform(window, residuals.begin(), [&](const DataPoint& sample) {
+        return std::abs(error(sample, slope, intercept));
+      });
+      const auto median = std::next(residuals.begin(), static_cast<std::int64_t>(num_samples / 2));
+      std::nth_element(residuals.begin(), median, residuals.end());
+      threshold = HUBER_K * MAD_TO_SIGMA * (*median);
+    }
+
+    double sum_w = 0.0;
+    double sum_wx = 0.0;
+    double sum_wy = 0.0;
+    double sum_wxx = 0.0;
+    double sum_wxy = 0.0;
+    for (const auto& sample : window) {
+      const auto w = weight(error(sample, slope, intercept), threshold);
+      const auto x = sample.x - origin.x;
+      const auto y = sample.y - origin.y;
+      sum_w += w;
+      sum_wx += w * x;
+      sum_wy += w * y;
+      sum_wxx += w * x * x;
+      sum_wxy += w * x * y;
+    }
+
+    const auto denom = std::fma(sum_wx, -sum_wx, sum_w * sum_wxx);
+    if (denom == 0.) {
+      // all the weight is on a single x: ill-conditioned from the start, or keep the last estimate
+      if (iteration == 0U) {
+        return fitBatch();
+      }
+      break;
+    }
+    const auto next_slope = std::fma(sum_wx, -sum_wy, sum_w * sum_wxy) / denom;
+    const auto next_intercept = std::fma(next_slope, -sum_wx, sum_wy) / sum_w;
+
+    // converged when the fitted line moves by much less than the noise anywhere in the window
+    const auto change =
+        (std::abs(next_slope - slope) * span_x) + std::abs(next_intercept - intercept);
+    slope = next_slope;
+    intercept = next_intercept;
+    if (iteration > 0U and change <= TOLERANCE * threshold) {
+      break;
+    }
+  }
+
+  // Mean squared error of the final fit over the inliers
+  auto num_inliers = 0UZ;
+  double sum_error_squared = 0.0;
+  for (const auto& sample : window) {
+    const auto err = error(sample, slope, intercept);
+    if (std::abs(err) <= threshold) {
+      ++num_inliers;
+      sum_error_squared += err * err;
+    }
+  }
+  const auto mse = (num_inliers > 0U) ? sum_error_squared / static_cast<double>(num_inliers) : 0.;
+
+  return FitParams{ .slope = slope,
+                    .intercept = std::fma(-slope, origin.x, origin.y) + intercept,
+                    .mse = mse };
 }
 
 #define USE_TRANSFORM_REDUCE
 #ifdef USE_TRANSFORM_REDUCE
 
 //-------------------------------------------------------------------------------------------------
-inline auto LineFitter::fit() const -> std::optional<FitParams> {
+inline auto LineFitter::fitBatch() const -> std::optional<FitParams> {
   if (write_index_ < 2U) {
     return std::nullopt;
   }
@@ -77,9 +334,14 @@ inline auto LineFitter::fit() const -> std::optional<FitParams> {
   // - slope = (n.∑(xᵢ.yᵢ) − ∑xᵢ.∑yᵢ) / (n.∑(xᵢ²) − (∑xᵢ)²),
   // - intercept = (∑yᵢ − slope.∑xᵢ) / n,
   // - mse = ∑(yᵢ - ŷᵢ)² / n, where ŷᵢ = slope.xᵢ + intercept
+  // Sums are taken relative to the oldest sample in the window, and the intercept shifted back at
+  // the end, so that large x and y don't cancel out in the denominator
 
-  const auto componentise = [](const auto& sample) {
-    return std::tuple{ sample.x, sample.y, sample.x * sample.x, sample.x * sample.y };
+  const auto origin = oldestSample();
+  const auto componentise = [&origin](const auto& sample) {
+    const auto x = sample.x - origin.x;
+    const auto y = sample.y - origin.y;
+    return std::tuple{ x, y, x * x, x * y };
   };
   const auto sum = [](const auto& aa, const auto& bb) {
     return std::tuple{ std::get<0>(aa) + std::get<0>(bb), std::get<1>(aa) + std::get<1>(bb),
@@ -96,23 +358,25 @@ inline auto LineFitter::fit() const -> std::optional<FitParams> {
   const auto intercept = std::fma(slope, -sum_x, sum_y) / num_samples;
 
   // Compute mean-squared-error
-  const auto error_squared = [slope, intercept](const auto& sample) {
-    const auto predicted_y = std::fma(slope, sample.x, intercept);
-    const auto error = sample.y - predicted_y;
+  const auto error_squared = [&origin, slope, intercept](const auto& sample) {
+    const auto predicted_y = std::fma(slope, sample.x - origin.x, intercept);
+    const auto error = (sample.y - origin.y) - predicted_y;
     return error * error;
   };
   const auto sum_error_squared =
       std::transform_reduce(samples_.begin(), samples_end, 0.0, std::plus<>{}, error_squared);
   const auto mse = sum_error_squared / num_samples;
 
-  return FitParams{ .slope = slope, .intercept = intercept, .mse = mse };
+  return FitParams{ .slope = slope,
+                    .intercept = std::fma(-slope, origin.x, origin.y) + intercept,
+                    .mse = mse };
 }
 
 #else
 
 //-------------------------------------------------------------------------------------------------
 /// Implementation using standard for loops instead of transform_reduce
-[[nodiscard]] inline auto LineFitter::fit() const -> std::optional<FitParams> {
+[[nodiscard]] inline auto LineFitter::fitBatch() const -> std::optional<FitParams> {
   if (write_index_ < 2U) {
     return std::nullopt;
   }
@@ -122,7 +386,8 @@ inline auto LineFitter::fit() const -> std::optional<FitParams> {
   // - intercept = (∑yᵢ − slope.∑xᵢ) / n,
   // - mse = ∑(yᵢ - ŷᵢ)² / n, where ŷᵢ = slope.xᵢ + intercept
 
-  // Compute sums using standard for loops
+  // Compute sums relative to the oldest sample using standard for loops
+  const auto origin = oldestSample();
   double sum_x = 0.0;
   double sum_y = 0.0;
   double sum_xx = 0.0;
@@ -136,10 +401,12 @@ inline auto LineFitter::fit() const -> std::optional<FitParams> {
           samples_.end();
 
   for (const auto& sample : std::span{ samples_.begin(), samples_end }) {
-    sum_x += sample.x;
-    sum_y += sample.y;
-    sum_xx += sample.x * sample.x;
-    sum_xy += sample.x * sample.y;
+    const auto x = sample.x - origin.x;
+    const auto y = sample.y - origin.y;
+    sum_x += x;
+    sum_y += y;
+    sum_xx += x * x;
+    sum_xy += x * y;
   }
 
   const auto num_samples = static_cast<double>((write_index_ < buf_size) ? write_index_ : buf_size);
@@ -150,13 +417,15 @@ inline auto LineFitter::fit() const -> std::optional<FitParams> {
   // Compute mean-squared-error using standard for loop
   double sum_error_squared = 0.0;
   for (const auto& sample : std::span{ samples_.begin(), samples_end }) {
-    const auto predicted_y = std::fma(slope, sample.x, intercept);
-    const auto error = sample.y - predicted_y;
+    const auto predicted_y = std::fma(slope, sample.x - origin.x, intercept);
+    const auto error = (sample.y - origin.y) - predicted_y;
     sum_error_squared += error * error;
   }
   const auto mse = sum_error_squared / num_samples;
 
-  return FitParams{ .slope = slope, .intercept = intercept, .mse = mse };
+  return FitParams{ .slope = slope,
+                    .intercept = std::fma(-slope, origin.x, origin.y) + intercept,
+                    .mse = mse };
 }
 #endif
 }  // namespace grape::ego_clock
@@ -0,0 +1,183 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace grape::ego_clock {
+
+//=================================================================================================
+/// Sequence lock: single writer, any number of non-blocking readers that spin (no syscalls) while a
+/// store is in progress
+///
+/// The writer makes the sequence number odd, stores the value, then makes it even again. Readers
+/// copy the value between two loads of the sequence number and retry if it was odd or has changed.
+/// The value is held in atomic words, so that a copy racing with a store is well-defined (just
+/// discarded), rather than a data race. Nothing is computed from a copy until it is known not to
+/// be torn. Readers never block the writer and never make a system
+/// call. They are not wait-free: a reader retries for as long as stores keep overlapping its copy,
+/// so it only makes progress while the writer does. With stores nanoseconds long and far apart, a
+/// retry is rare and costs a few nanoseconds (see 'max_ns' of bmEgoClockNowContended).
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+class SeqLock {
+public:
+  /// Publish a new value. Not safe to call from multiple threads
+  void store(const T& value);
+
+  /// Replace the value with a function of the current value. Readers see either the old value or
+  /// the new one, and any reader that sees the old value finished reading before 'fn' was called.
+  /// Not safe to call from multiple threads
+  /// @param fn Called as fn(const T& current) -> T
+  template <typename Fn>
+  void update(Fn&& fn);
+
+  /// @return Copy of the latest value
+  [[nodiscard]] auto load() const -> T;
+
+  /// Take a sample (e.g. the time) while a value is the latest, then evaluate a function of both.
+  /// The sample is taken before the next update() calls its function. 'compute' only sees a value
+  /// that was stored in full, never one torn by a concurrent store
+  /// @param sample Called as sample(), while copying the value. Must have no side effects, as it
+  /// is repeated if a store overlaps the copy
+  /// @param compute Called once as compute(const T& value, sample_result), after the copy
+  /// @return Result of compute
+  template <typename Sample, typename Compute>
+  [[nodiscard]] auto read(Sample&& sample, Compute&& compute) const;
+
+  /// @return Number of stores started times 2. Odd while a store is in progress, 0 if none yet
+  [[nodiscard]] auto version() const -> std::uint64_t;
+
+private:
+  using Word = std::uint64_t;
+  static constexpr auto NUM_WORDS = (sizeof(T) + sizeof(Word) - 1U) / sizeof(Word);
+  static constexpr auto CACHE_LINE_SIZE = 64U;
+  using Words = std::array<Word, NUM_WORDS>;
+
+  static void cpuRelax();
+  [[nodiscard]] auto loadWords() const -> Words;
+  void storeWords(const T& value);
+  [[nodiscard]] static auto fromWords(const Words& words) -> T;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> seq_{ 0U };
+  std::array<std::atomic<Word>, NUM_WORDS> words_{};
+};
+
+//-------------------------------------------------------------------------------------------------
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+void SeqLock<T>::store(const T& value) {
+  const auto seq = seq_.load(std::memory_order_relaxed);
+  seq_.store(seq + 1U, std::memory_order_relaxed);  // Begin write (odd count)
+  std::atomic_thread_fence(std::memory_order_release);  // ..ordered before the words below
+  storeWords(value);
+  seq_.store(seq + 2U, std::memory_order_release);  // End write (even count)
+}
+
+//-------------------------------------------------------------------------------------------------
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+template <typename Fn>
+void SeqLock<T>::update(Fn&& fn) {
+  const auto seq = seq_.load(std::memory_order_relaxed);
+  seq_.store(seq + 1U, std::memory_order_relaxed);  // Begin write (odd count)
+  // Full fence: readers that still see an even count have done all their reads before fn is called
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  storeWords(std::forward<Fn>(fn)(fromWords(loadWords())));
+  seq_.store(seq + 2U, std::memory_order_release);  // End write (even count)
+}
+
+//-------------------------------------------------------------------------------------------------
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+auto SeqLock<T>::load() const -> T {
+  while (true) {
+    const auto seq_before = seq_.load(std::memory_order_acquire);
+    if ((seq_before & 1U) == 0U) {
+      const auto words = loadWords();
+      std::atomic_thread_fence(std::memory_order_acquire);  // reads above are done before seq
+      if (seq_.load(std::memory_order_relaxed) == seq_before) {
+        return fromWords(words);
+      }
+    }
+    cpuRelax();
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+template <typename Sample, typename Compute>
+auto SeqLock<T>::read(Sample&& sample, Compute&& compute) const {
+  while (true) {
+    const auto seq_before = seq_.load(std::memory_order_acquire);
+    if ((seq_before & 1U) == 0U) {
+      const auto words = loadWords();
+      const auto sampled = sample();
+      std::atomic_thread_fence(std::memory_order_acquire);  // reads above are done before seq
+      if (seq_.load(std::memory_order_relaxed) == seq_before) {
+        // Only now are the words known to be a value stored in full, so safe to compute with
+        return std::forward<Compute>(compute)(fromWords(words), sampled);
+      }
+    }
+    cpuRelax();  // writer is active. It finishes within nanoseconds, so spin rather than yield
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+auto SeqLock<T>::loadWords() const -> Words {
+  auto words = Words{};
+  for (auto i = 0UZ; i < NUM_WORDS; ++i) {
+    words.at(i) = words_.at(i).load(std::memory_order_relaxed);
+  }
+  return words;
+}
+
+//-------------------------------------------------------------------------------------------------
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+void SeqLock<T>::storeWords(const T& value) {
+  auto words = Words{};
+  std::memcpy(words.data(), &value, sizeof(T));
+  for (auto i = 0UZ; i < NUM_WORDS; ++i) {
+    words_.at(i).store(words.at(i), std::memory_order_relaxed);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+auto SeqLock<T>::fromWords(const Words& words) -> T {
+  auto value = T{};
+  std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+  return value;
+}
+
+//-------------------------------------------------------------------------------------------------
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+auto SeqLock<T>::version() const -> std::uint64_t {
+  return seq_.load(std::memory_order_acquire);
+}
+
+//-------------------------------------------------------------------------------------------------
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+void SeqLock<T>::cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+}  // namespace grape::ego_clock
@@ -0,0 +1,86 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <utility>
+
+namespace grape::ego_clock {
+
+//=================================================================================================
+/// On-disk layout of a tick log (see EgoClockTickLogWriter)
+///
+/// A 16 byte header is followed by one record per tick, back to back. A record is the change in
+/// ego time then the change in wall time since the previous tick (or since zero, for the first),
+/// each zigzag encoded (so small negative changes stay small) and written as an LEB128 varint:
+/// 7 bits per byte, least significant first, top bit set on all but the last byte. Ticks up to
+/// 1 ms apart take 6 bytes, and up to 134 ms apart 8 bytes, against 16 for raw int64 pairs.
+///
+/// The format only ever grows at the end, so a log can be mapped and read while it is written. A
+/// record cut short by a crash is ignored by readers, and overwritten when appending again.
+struct TickLogFormat {
+  static constexpr auto MAGIC = std::array<char, 8>{ 'G', 'R', 'P', 'T', 'I', 'C', 'K', 'S' };
+  static constexpr auto VERSION = std::uint32_t{ 1U };
+  static constexpr auto MAX_VARINT_BYTES = 10U;  //!< ceil(64 / 7)
+  static constexpr auto VARINT_PAYLOAD = 0x7FU;  //!< Value bits of a varint byte
+  static constexpr auto VARINT_MORE = 0x80U;     //!< Set if more bytes follow
+  static constexpr auto MAX_RECORD_BYTES = 2U * MAX_VARINT_BYTES;
+
+  struct Header {
+    std::array<char, 8> magic{ MAGIC };
+    std::uint32_t version{ VERSION };
+    std::uint32_t reserved{ 0U };
+  };
+  static_assert(sizeof(Header) == 16U);
+};
+
+//-------------------------------------------------------------------------------------------------
+constexpr auto zigzagEncode(std::int64_t value) -> std::uint64_t {
+  return (static_cast<std::uint64_t>(value) << 1U) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+//-------------------------------------------------------------------------------------------------
+constexpr auto zigzagDecode(std::uint64_t value) -> std::int64_t {
+  return static_cast<std::int64_t>(value >> 1U) ^ -static_cast<std::int64_t>(value & 1U);
+}
+
+//-------------------------------------------------------------------------------------------------
+/// Write a varint to the start of 'out', which must have space for MAX_VARINT_BYTES
+/// @return Number of bytes written
+constexpr auto encodeVarint(std::uint64_t value, std::span<std::byte> out) -> std::size_t {
+  auto n = 0U;
+  while (value > TickLogFormat::VARINT_PAYLOAD) {
+    const auto payload = value & TickLogFormat::VARINT_PAYLOAD;
+    out[n++] = static_cast<std::byte>(payload | TickLogFormat::VARINT_MORE);
+    value >>= 7U;
+  }
+  out[n++] = static_cast<std::byte>(value);
+  return n;
+}
+
+//-------------------------------------------------------------------------------------------------
+/// Read a varint from the start of 'in'
+/// @return The value and number of bytes it took, or nothing if 'in' ends before the varint does
+/// or it is longer than MAX_VARINT_BYTES
+constexpr auto decodeVarint(std::span<const std::byte> in)
+    -> std::optional<std::pair<std::uint64_t, std::size_t>> {
+  auto value = std::uint64_t{ 0U };
+  const auto max_bytes = std::min<std::size_t>(in.size(), TickLogFormat::MAX_VARINT_BYTES);
+  for (auto n = 0U; n < max_bytes; ++n) {
+    const auto byte = std::to_integer<std::uint64_t>(in[n]);
+    value |= (byte & TickLogFormat::VARINT_PAYLOAD) << (7U * n);
+    if ((byte & TickLogFormat::VARINT_MORE) == 0U) {
+      return std::pair{ value, n + 1U };
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace grape::ego_clock
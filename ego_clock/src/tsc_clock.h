@@ -0,0 +1,148 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <thread>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#include "grape/wall_clock.h"
+
+namespace grape::ego_clock {
+
+//=================================================================================================
+/// CPU time stamp counter (TSC), as a cheaper time source than the wall clock
+///
+/// Reading the TSC takes a few nanoseconds, against a few tens for clock_gettime() through the
+/// vDSO. TSC ticks are converted to wall clock time with a TscCalibration.
+struct TscClock {
+  /// @return true if the kernel itself keeps time with the TSC, which it only does if the TSC runs
+  /// at a constant rate and is synchronised across cores. Always false other than on x86-64
+  [[nodiscard]] static auto isAvailable() -> bool;
+
+  /// @return Current TSC value. Read after all earlier instructions (including loads) have
+  /// completed and before any later one starts, so that it can be read inside a SeqLock::read()
+  [[nodiscard]] static auto now() noexcept -> std::int64_t;
+};
+
+//=================================================================================================
+/// Rate of the TSC measured against the wall clock
+///
+/// The rate is estimated from the wall clock and TSC readings at the start and end of each
+/// CALIBRATION_PERIOD, so a step of the wall clock only upsets one estimate. Not thread-safe.
+class TscCalibration {
+public:
+  /// Wall clock and TSC read at the same time
+  struct Sample {
+    std::int64_t wall_ns{ 0 };
+    std::int64_t ticks{ 0 };
+  };
+
+  static constexpr auto CALIBRATION_PERIOD = std::chrono::seconds(1);
+  static constexpr auto INITIAL_CALIBRATION_PERIOD = std::chrono::milliseconds(10);
+
+  /// Makes an initial estimate, sleeping for INITIAL_CALIBRATION_PERIOD
+  TscCalibration();
+
+  /// @return A new sample, after updating the rate if a calibration period has passed
+  [[nodiscard]] auto update() -> Sample;
+
+  /// @return Wall clock nanoseconds per TSC tick
+  [[nodiscard]] auto nsPerTick() const -> double {
+    return ns_per_tick_;
+  }
+
+  /// @return Wall clock and TSC, read as close together as the scheduler allows
+  [[nodiscard]] static auto sample() -> Sample;
+
+private:
+  [[nodiscard]] static auto rate(const Sample& from, const Sample& to) -> double;
+
+  Sample reference_;
+  double ns_per_tick_{ 1. };
+};
+
+//-------------------------------------------------------------------------------------------------
+inline auto TscClock::isAvailable() -> bool {
+#if defined(__x86_64__)
+  auto file = std::ifstream("/sys/devices/system/clocksource/clocksource0/current_clocksource");
+  auto clock_source = std::string{};
+  file >> clock_source;
+  return clock_source == "tsc";
+#else
+  return false;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto TscClock::now() noexcept -> std::int64_t {
+#if defined(__x86_64__)
+  auto aux = 0U;
+  const auto ticks = __rdtscp(&aux);
+  _mm_lfence();
+  return static_cast<std::int64_t>(ticks);
+#else
+  return 0;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+inline TscCalibration::TscCalibration() {
+  auto now = sample();
+  do {  // again if the wall clock steps back meanwhile
+    reference_ = now;
+    std::this_thread::sleep_for(INITIAL_CALIBRATION_PERIOD);
+    now = sample();
+  } while (now.wall_ns <= reference_.wall_ns);
+  ns_per_tick_ = rate(reference_, now);
+  reference_ = now;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto TscCalibration::update() -> Sample {
+  const auto now = sample();
+  const auto elapsed_ns = now.wall_ns - reference_.wall_ns;
+  if (elapsed_ns >= std::chrono::nanoseconds(CALIBRATION_PERIOD).count()) {
+    ns_per_tick_ = rate(reference_, now);
+    reference_ = now;
+  } else if (elapsed_ns < 0) {
+    reference_ = now;  // wall clock stepped back. Start over
+  }
+  return now;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto TscCalibration::sample() -> Sample {
+  // Bracket the wall clock between two TSC reads, keeping the tightest of a few tries in case one
+  // is preempted
+  static constexpr auto NUM_TRIES = 3;
+  auto best = Sample{};
+  auto best_gap = std::numeric_limits<std::int64_t>::max();
+  for (auto i = 0; i < NUM_TRIES; ++i) {
+    const auto before = TscClock::now();
+    const auto wall_ns = WallClock::toNanos(WallClock::now());
+    const auto after = TscClock::now();
+    if (after - before < best_gap) {
+      best_gap = after - before;
+      best = { .wall_ns = wall_ns, .ticks = before + ((after - before) / 2) };
+    }
+  }
+  return best;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline auto TscCalibration::rate(const Sample& from, const Sample& to) -> double {
+  const auto elapsed_ns = static_cast<double>(to.wall_ns - from.wall_ns);
+  return elapsed_ns / static_cast<double>(to.ticks - from.ticks);
+}
+
+}  // namespace grape::ego_clock
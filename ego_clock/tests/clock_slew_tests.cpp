@@ -0,0 +1,278 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "../src/clock_slew.h"
+#include "../src/seqlock.h"
+#include "catch2/catch_test_macros.hpp"
+
+namespace {
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+using grape::ego_clock::ClockTransform;
+using grape::ego_clock::SlewedTransform;
+using grape::ego_clock::TimeSample;
+using grape::ego_clock::slewTo;
+using grape::ego_clock::toEgoNanos;
+using grape::ego_clock::wallTimeUntil;
+using namespace std::chrono_literals;
+
+constexpr auto WALL_START_NS = 1'700'000'000'000'000'000LL;  // wall clock times are since 1970
+constexpr auto SLEW_WINDOW = std::chrono::duration_cast<grape::WallClock::Duration>(100ms);
+
+//-------------------------------------------------------------------------------------------------
+// Transform for an ego clock that started at WALL_START_NS + start_offset_ns, running at 'scale'
+// wall nanoseconds per ego nanosecond
+auto makeTransform(std::int64_t start_offset_ns, double scale = 1.) -> ClockTransform {
+  return { .wall_origin_ns = WALL_START_NS + start_offset_ns, .scale = scale };
+}
+
+//-------------------------------------------------------------------------------------------------
+// Ego time the transform itself gives, to compare with the slewed one
+auto targetEgoNanos(const ClockTransform& tf, std::int64_t wall_ns) -> std::int64_t {
+  const auto tp = grape::ego_clock::toEgoTime(tf, grape::WallClock::fromNanos(wall_ns));
+  return grape::EgoClock::toNanos(tp);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Time source reading at a wall clock time, for a time source ticking every 'ns_per_tick' that
+// reads the same as the wall clock at WALL_START_NS
+auto sampleAt(std::int64_t wall_ns, double ns_per_tick = 1.) -> TimeSample {
+  const auto elapsed_ticks = static_cast<double>(wall_ns - WALL_START_NS) / ns_per_tick;
+  return { .wall_ns = wall_ns,
+           .ticks = WALL_START_NS + std::llround(elapsed_ticks),
+           .ns_per_tick = ns_per_tick };
+}
+
+//-------------------------------------------------------------------------------------------------
+// Apply 'next' at wall time WALL_START_NS + 1 s, after 'first'. Check ego time is monotonic from
+// 1 ms before until 'duration' after, in 'step' increments, and has converged to 'next' by then
+void checkSlew(const ClockTransform& first, const ClockTransform& next,
+               std::chrono::nanoseconds duration, std::chrono::nanoseconds step = 10us,
+               double ns_per_tick = 1.) {
+  const auto t0 = WALL_START_NS + 1'000'000'000LL;
+  const auto ticks = [ns_per_tick](std::int64_t t) { return sampleAt(t, ns_per_tick).ticks; };
+  const auto before =
+      slewTo(SlewedTransform{}, first, sampleAt(WALL_START_NS, ns_per_tick), SLEW_WINDOW);
+  const auto after = slewTo(before, next, sampleAt(t0, ns_per_tick), SLEW_WINDOW);
+
+  auto last = toEgoNanos(before, ticks(t0 - 1'000'000));
+  auto num_backwards = 0;
+  for (auto t = t0 - 1'000'000; t <= t0 + duration.count(); t += step.count()) {
+    const auto ego_ns = (t < t0) ? toEgoNanos(before, ticks(t)) : toEgoNanos(after, ticks(t));
+    if (ego_ns < last) {
+      ++num_backwards;
+    }
+    last = ego_ns;
+  }
+  REQUIRE(num_backwards == 0);
+
+  // double has 256 ns resolution at wall clock times
+  const auto end = t0 + duration.count();
+  REQUIRE(std::abs(toEgoNanos(after, ticks(end)) - targetEgoNanos(next, end)) < 1000);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("First transform is applied at once", "[clock_slew]") {
+  const auto tf = makeTransform(0);
+  const auto slewed = slewTo(SlewedTransform{}, tf, sampleAt(WALL_START_NS + 5'000), SLEW_WINDOW);
+  REQUIRE(toEgoNanos(slewed, WALL_START_NS + 5'000) == targetEgoNanos(tf, WALL_START_NS + 5'000));
+  // Only the start is rounded to double resolution at wall clock times (256 ns)
+  REQUIRE(toEgoNanos(slewed, WALL_START_NS + 9'000) - toEgoNanos(slewed, WALL_START_NS + 5'000) ==
+          4'000);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Ego time doesn't step when the transform does", "[clock_slew]") {
+  const auto first = makeTransform(0);
+
+  SECTION("Step forwards is caught up over the slew window") {
+    checkSlew(first, makeTransform(-5'000'000), SLEW_WINDOW);
+  }
+
+  SECTION("Step backwards is caught up over the slew window") {
+    checkSlew(first, makeTransform(5'000'000), SLEW_WINDOW);
+  }
+
+  SECTION("Large step backwards is caught up over a longer window") {
+    // 1 s back can't be made up in 100 ms without going backwards: takes 2 s at half speed
+    checkSlew(first, makeTransform(1'000'000'000), 2'000ms, 1ms);
+  }
+
+  SECTION("Rate change") {
+    checkSlew(first, makeTransform(0, 1.001), SLEW_WINDOW);
+    checkSlew(first, makeTransform(0, 0.5), SLEW_WINDOW);
+    // Half speed and 0.5 s back: 2 s at a quarter speed
+    checkSlew(first, makeTransform(1'000'000, 2.), 2'100ms, 1ms);
+  }
+
+  SECTION("In ticks of a 2.5 GHz time source") {
+    static constexpr auto NS_PER_TICK = 0.4;
+    checkSlew(first, makeTransform(-5'000'000), SLEW_WINDOW, 10us, NS_PER_TICK);
+    checkSlew(first, makeTransform(5'000'000), SLEW_WINDOW, 10us, NS_PER_TICK);
+    checkSlew(first, makeTransform(1'000'000'000), 2'000ms, 1ms, NS_PER_TICK);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Apply 'next' at wall time WALL_START_NS + 1 s, after 'first'. Check that the wall time until ego
+// times up to 'duration' on reaches each of them to within a nanosecond, from the start of the slew
+void checkWallTimeUntil(const ClockTransform& first, const ClockTransform& next,
+                        std::chrono::nanoseconds duration, double ns_per_tick = 1.) {
+  const auto t0 = WALL_START_NS + 1'000'000'000LL;
+  const auto before =
+      slewTo(SlewedTransform{}, first, sampleAt(WALL_START_NS, ns_per_tick), SLEW_WINDOW);
+  const auto after = slewTo(before, next, sampleAt(t0, ns_per_tick), SLEW_WINDOW);
+  const auto start = sampleAt(t0, ns_per_tick);
+  const auto start_ego_ns = toEgoNanos(after, start.ticks);
+
+  auto num_early = 0;
+  auto num_late = 0;
+  for (auto ego_dt = 0LL; ego_dt <= duration.count(); ego_dt += duration.count() / 100) {
+    const auto ego_ns = start_ego_ns + ego_dt;
+    const auto wait = wallTimeUntil(after, start.ticks, ego_ns);
+    const auto wake = sampleAt(t0 + wait.count(), ns_per_tick);
+    if (toEgoNanos(after, wake.ticks) < ego_ns) {
+      ++num_early;
+    }
+    if (wait > 1ns and wallTimeUntil(after, sampleAt(t0 + wait.count() - 2, ns_per_tick).ticks,
+                                     ego_ns) == 0ns) {
+      ++num_late;
+    }
+  }
+  REQUIRE(num_early == 0);
+  REQUIRE(num_late == 0);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Wall time until an ego time follows the slew", "[clock_slew]") {
+  const auto first = makeTransform(0);
+  checkWallTimeUntil(first, first, SLEW_WINDOW);
+  checkWallTimeUntil(first, makeTransform(-5'000'000), 2 * SLEW_WINDOW);
+  checkWallTimeUntil(first, makeTransform(5'000'000), 2 * SLEW_WINDOW);
+  checkWallTimeUntil(first, makeTransform(1'000'000'000), 3'000ms);
+  checkWallTimeUntil(first, makeTransform(1'000'000, 2.), 3'000ms);
+  checkWallTimeUntil(first, makeTransform(-5'000'000), 2 * SLEW_WINDOW, 0.4);
+  checkWallTimeUntil(first, makeTransform(5'000'000), 2 * SLEW_WINDOW, 0.4);
+
+  // Nothing to wait for once reached
+  const auto slewed = slewTo(SlewedTransform{}, first, sampleAt(WALL_START_NS), SLEW_WINDOW);
+  REQUIRE(wallTimeUntil(slewed, WALL_START_NS + 10, toEgoNanos(slewed, WALL_START_NS)) == 0ns);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Sleeping until an ego time wakes at it across a step of the transform",
+          "[clock_slew]") {
+  static constexpr auto STEP_NS = 20'000'000LL;
+
+  const auto wall_ns = [] { return grape::WallClock::toNanos(grape::WallClock::now()); };
+  const auto start_ns = wall_ns();
+  auto transform = grape::ego_clock::SeqLock<SlewedTransform>{};
+  const auto first = ClockTransform{ .wall_origin_ns = start_ns };
+  transform.store(slewTo({}, first, { .wall_ns = start_ns, .ticks = start_ns }, SLEW_WINDOW));
+
+  const auto now = [&transform, &wall_ns] {
+    return transform.read(wall_ns, toEgoNanos);
+  };
+  // As EgoClock::sleepUntil(): wait on the transform in use, then check again on waking
+  const auto sleep_until = [&transform, &wall_ns](std::int64_t ego_ns) {
+    auto wait = 1ns;
+    while (wait > 0ns) {
+      wait = transform.read(wall_ns, [ego_ns](const SlewedTransform& tf, std::int64_t now_ns) {
+        return wallTimeUntil(tf, now_ns, ego_ns);
+      });
+      std::this_thread::sleep_for(wait);
+    }
+  };
+  const auto step = [&transform, &wall_ns, start_ns](std::int64_t step_ns) {
+    const auto next = ClockTransform{ .wall_origin_ns = start_ns + step_ns };
+    transform.update([&next, &wall_ns](const SlewedTransform& current) {
+      const auto now_ns = wall_ns();
+      return slewTo(current, next, { .wall_ns = now_ns, .ticks = now_ns }, SLEW_WINDOW);
+    });
+  };
+  // Ego time 30 ms on from now
+  const auto target_ns = now() + 30'000'000LL;
+  auto woke_ns = std::int64_t{ 0 };
+
+  SECTION("Step backwards while asleep") {
+    // The slew back runs at half speed for 40 ms, so the sleeper has to wake later than it first
+    // expected in wall time
+    auto sleeper = std::jthread([&] {
+      sleep_until(target_ns);
+      woke_ns = now();
+    });
+    std::this_thread::sleep_for(5ms);
+    step(STEP_NS);
+  }
+
+  SECTION("Asleep while slewing forwards") {
+    // Ego time is behind the target transform during the slew, so sleeping until the target
+    // transform reaches the ego time would wake early
+    step(-STEP_NS);
+    sleep_until(target_ns);
+    woke_ns = now();
+  }
+
+  REQUIRE(woke_ns >= target_ns);
+  REQUIRE(woke_ns - target_ns < 5'000'000LL);  // allows for scheduling delays
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Ego time is monotonic while transforms change under concurrent readers",
+          "[clock_slew]") {
+  static constexpr auto NUM_READERS = 4U;
+  static constexpr auto NUM_UPDATES = 200;
+  static constexpr auto STEP_NS = 2'000'000LL;  // alternate between 2 ms ahead and behind
+
+  const auto start_ns = grape::WallClock::toNanos(grape::WallClock::now());
+  auto transform = grape::ego_clock::SeqLock<SlewedTransform>{};
+  const auto first = ClockTransform{ .wall_origin_ns = start_ns };
+  transform.store(slewTo({}, first, { .wall_ns = start_ns, .ticks = start_ns }, SLEW_WINDOW));
+
+  const auto now = [&transform] {
+    return transform.read([] { return grape::WallClock::toNanos(grape::WallClock::now()); },
+                          toEgoNanos);
+  };
+
+  auto done = std::atomic_bool{ false };
+  auto num_backwards = std::atomic<std::size_t>{ 0U };
+  auto readers = std::vector<std::jthread>{};
+  for (auto i = 0U; i < NUM_READERS; ++i) {
+    readers.emplace_back([&] {
+      auto last = now();
+      while (not done) {
+        const auto ego_ns = now();
+        if (ego_ns < last) {
+          ++num_backwards;
+        }
+        last = ego_ns;
+      }
+    });
+  }
+
+  for (auto i = 0; i < NUM_UPDATES; ++i) {
+    const auto step = (i % 2 == 0) ? STEP_NS : -STEP_NS;
+    const auto next = ClockTransform{ .wall_origin_ns = start_ns + step };
+    transform.update([&next](const SlewedTransform& current) {
+      const auto wall_ns = grape::WallClock::toNanos(grape::WallClock::now());
+      return slewTo(current, next, { .wall_ns = wall_ns, .ticks = wall_ns }, 1ms);
+    });
+    std::this_thread::sleep_for(1ms);
+  }
+  done = true;
+  readers.clear();
+
+  REQUIRE(num_backwards == 0U);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+}  // namespace
@@ -2,9 +2,21 @@
 // Copyright (C) 2025 GRAPE Contributors
 //=================================================================================================
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../src/ego_clock2_registry.h"
+#include "../src/ego_clock2_signal.h"
 #include "catch2/catch_test_macros.hpp"
 #include "grape/ego_clock2.h"
 #include "grape/ego_clock2_driver.h"
@@ -14,6 +26,24 @@ namespace {
 
 // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
 
+//-------------------------------------------------------------------------------------------------
+// Run fn in a child process, which exits with status 0 if fn returns true. For drivers in other
+// processes, that die without releasing what they hold
+auto spawn(const std::function<bool()>& fn) -> pid_t {
+  const auto pid = fork();
+  if (pid == 0) {
+    _exit(fn() ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+  return pid;
+}
+
+//-------------------------------------------------------------------------------------------------
+// @return true if the child process exited with status 0
+auto reap(pid_t pid) -> bool {
+  auto status = 0;
+  return (waitpid(pid, &status, 0) == pid) and WIFEXITED(status) and (WEXITSTATUS(status) == 0);
+}
+
 //-------------------------------------------------------------------------------------------------
 TEST_CASE("EgoClock2 time conversion utilities", "[ego_clock2]") {
   SECTION("toNanos and fromNanos are inverse operations") {
@@ -76,6 +106,356 @@ TEST_CASE("EgoClock2 clock properties", "[ego_clock2]") {
   static_assert(std::is_same_v<typename TimePoint::duration, Duration>);
 }
 
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("EgoClock2 interpolates between ticks", "[ego_clock2]") {
+  using grape::ego_clock::interpolate;
+
+  // 10 ms ego ticks posted every 100 ms of monotonic time
+  const auto tick = grape::ego_clock::EgoClock2Tick{
+    .ego_nanos = 50'000'000, .wall_nanos = 1'000'000'000, .step_nanos = 10'000'000, .rate = 0.1
+  };
+
+  SECTION("Returns the tick time when posted") {
+    REQUIRE(interpolate(tick, 1'000'000'000) == 50'000'000);
+  }
+
+  SECTION("Advances at the estimated rate") {
+    REQUIRE(interpolate(tick, 1'050'000'000) == 55'000'000);
+  }
+
+  SECTION("Stops one step past the tick if the next tick is late") {
+    REQUIRE(interpolate(tick, 1'200'000'000) == 60'000'000);
+    REQUIRE(interpolate(tick, 1'000'000'000'000'000) == 60'000'000);
+  }
+
+  SECTION("Never goes before the tick") {
+    REQUIRE(interpolate(tick, 0) == 50'000'000);
+  }
+
+  SECTION("Returns the tick time until the rate is known") {
+    auto first_tick = tick;
+    first_tick.rate = 0.;
+    REQUIRE(interpolate(first_tick, 1'050'000'000) == 50'000'000);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("EgoClock2 interpolation is monotonic when the tick step shrinks", "[ego_clock2]") {
+  using grape::ego_clock::interpolate;
+
+  auto signal = std::make_unique<grape::ego_clock::EgoClock2Signal>();
+  const auto now = [&signal](std::int64_t wall_nanos) {
+    return interpolate(signal->getTick(), wall_nanos);
+  };
+
+  // 10 ns ticks, then a 5 ns one: readers got to 110 before the tick at 105
+  signal->post({ .ego_nanos = 100, .wall_nanos = 1'000, .step_nanos = 10, .rate = 1. });
+  REQUIRE(now(1'020) == 110);
+  signal->post({ .ego_nanos = 105, .wall_nanos = 1'030, .step_nanos = 5, .rate = 0.5 });
+  REQUIRE(now(1'030) == 110);
+  REQUIRE(now(1'100) == 110);
+
+  // Held until later ticks catch up, however often the step shrinks
+  signal->post({ .ego_nanos = 107, .wall_nanos = 1'110, .step_nanos = 2, .rate = 0.1 });
+  REQUIRE(now(1'200) == 110);
+  signal->post({ .ego_nanos = 117, .wall_nanos = 1'210, .step_nanos = 10, .rate = 0.1 });
+  REQUIRE(now(1'210) == 117);
+  REQUIRE(now(1'260) == 122);
+
+  // Unless time is reset backwards
+  signal->post({ .ego_nanos = 0, .wall_nanos = 1'300 });
+  REQUIRE(now(1'300) == 0);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("EgoClock2 signal never loses a wake-up", "[ego_clock2]") {
+  using namespace std::chrono_literals;
+  static constexpr auto NUM_POSTS = 20'000;
+  static constexpr auto LOW_WORD = 0x5A5AU;
+
+  // Every value has the same low 32 bits, including the initial 0 for the low word check, so a
+  // futex wait on the 64-bit value would not see the change. The poster waits for each value to be
+  // seen before posting the next, so that every post races with the waiter going to sleep
+  const auto adversarial = [](int i) -> std::int64_t {
+    const auto high = static_cast<std::int64_t>((i % 2 == 0) ? i : -i) * (1LL << 32);
+    return (i == 0) ? 0 : high + LOW_WORD;
+  };
+
+  auto signal = std::make_unique<grape::ego_clock::EgoClock2Signal>();
+
+  // A change in the high word only, made before the wait starts, is seen at once
+  signal->post({ .ego_nanos = LOW_WORD });
+  signal->post({ .ego_nanos = adversarial(1) });
+  const auto wait_start = std::chrono::steady_clock::now();
+  REQUIRE(signal->wait(LOW_WORD, 1s));
+  REQUIRE(std::chrono::steady_clock::now() - wait_start < 500ms);
+  signal->post({ .ego_nanos = adversarial(0) });
+
+  auto num_seen = std::atomic<int>{ 0 };
+  auto num_timeouts = 0;
+
+  // Read before the first post below: a waiter thread starting after it would wait for it forever
+  const auto first = signal->get();
+  auto waiter = std::jthread([&] {
+    auto last = first;
+    for (auto i = 1; i <= NUM_POSTS; ++i) {
+      while (signal->get() == last) {
+        if (not signal->wait(last, 1s)) {
+          ++num_timeouts;
+        }
+      }
+      last = signal->get();
+      num_seen.store(i, std::memory_order_release);
+      num_seen.notify_one();
+    }
+  });
+
+  for (auto i = 1; i <= NUM_POSTS; ++i) {
+    signal->post({ .ego_nanos = adversarial(i) });
+    num_seen.wait(i - 1, std::memory_order_acquire);
+  }
+  waiter.join();
+
+  REQUIRE(num_timeouts == 0);
+  REQUIRE(signal->get() == adversarial(NUM_POSTS));
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("EgoClock2 ticks wake only sleepers that are due", "[ego_clock2]") {
+  using namespace std::chrono_literals;
+  static constexpr auto NUM_SLEEPERS = 16;
+  static constexpr auto STEP = 1'000'000LL;  // 1 ms ego ticks, one wake bucket each
+
+  auto signal = std::make_unique<grape::ego_clock::EgoClock2Signal>();
+  signal->bucket_width = STEP;
+  signal->post({ .ego_nanos = STEP });
+
+  // Sleeper i waits for tick 2 * (i + 1)
+  auto num_late = std::atomic<int>{ 0 };
+  auto num_early_wakes = std::atomic<int>{ 0 };
+  auto sleepers = std::vector<std::jthread>{};
+  for (auto i = 0; i < NUM_SLEEPERS; ++i) {
+    sleepers.emplace_back([&signal, &num_late, &num_early_wakes, i] {
+      const auto deadline = 2 * (i + 1) * STEP;
+      while (signal->get() < deadline) {
+        if (not signal->waitUntil(deadline, 1000ms)) {
+          ++num_late;  // timed out: the tick reaching the deadline didn't wake us
+        } else if (signal->get() < deadline) {
+          ++num_early_wakes;
+        }
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(10ms);  // let the sleepers block
+  for (auto tick = 2; tick <= 2 * NUM_SLEEPERS; ++tick) {
+    signal->post({ .ego_nanos = tick * STEP });
+    std::this_thread::sleep_for(1ms);
+  }
+  sleepers.clear();
+
+  REQUIRE(num_late == 0);
+  // A sleeper's bucket is also woken by the tick before its deadline: at most once per sleeper
+  REQUIRE(num_early_wakes <= NUM_SLEEPERS);
+
+  // Sleepers are no longer counted once done, so later ticks skip their buckets
+  REQUIRE(signal->num_waiters == 0U);
+  REQUIRE(std::ranges::all_of(signal->buckets, [](const auto& bucket) {
+    return bucket.waiters == 0U;
+  }));
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("EgoClock2 registry slots", "[ego_clock2]") {
+  using Registry = grape::ego_clock::EgoClock2Registry;
+  static_assert(alignof(Registry::Slot) >= 64U, "slots must not share cache lines");
+
+  // Zero-filled, as a newly created segment, and shared with child processes
+  const auto unmap = [](void* memory) { munmap(memory, sizeof(Registry)); };
+  const auto mapping = std::unique_ptr<void, decltype(unmap)>(
+      mmap(nullptr, sizeof(Registry), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0),
+      unmap);
+  REQUIRE(mapping.get() != MAP_FAILED);
+  auto* registry = static_cast<Registry*>(mapping.get());
+  REQUIRE(registry->find("robot_1") == nullptr);
+
+  SECTION("Finds claimed clocks by name") {
+    auto* robot_1 = registry->claim("robot_1", 1000);
+    auto* robot_2 = registry->claim("robot_2", 1000);
+    REQUIRE(robot_1 != nullptr);
+    REQUIRE(robot_2 != nullptr);
+    REQUIRE(robot_1 != robot_2);
+    REQUIRE(registry->find("robot_1") == robot_1);
+    REQUIRE(registry->find("robot_2") == robot_2);
+    REQUIRE(registry->find("robot") == nullptr);
+
+    robot_1->post({ .ego_nanos = 42 });
+    REQUIRE(registry->find("robot_1")->get() == 42);
+    REQUIRE(registry->find("robot_2")->get() == 0);
+  }
+
+  SECTION("Released slots are reused") {
+    auto* robot_1 = registry->claim("robot_1", 1000);
+    registry->release(robot_1);
+    REQUIRE(registry->find("robot_1") == nullptr);
+    REQUIRE(registry->claim("robot_3", 1000) == robot_1);
+  }
+
+  SECTION("A driver restarting with the same name takes over its slot once the last one died") {
+    REQUIRE(reap(spawn([registry] {
+      auto* robot_1 = registry->claim("robot_1", 1000);
+      if (robot_1 != nullptr) {
+        robot_1->post({ .ego_nanos = 42 });
+      }
+      return robot_1 != nullptr;  // and dies without releasing it
+    })));
+    const auto* dead = registry->find("robot_1");
+    REQUIRE(dead != nullptr);
+    REQUIRE(dead->get() == 42);
+    REQUIRE(registry->claim("robot_1", 1000) == dead);
+    REQUIRE(dead->get() == 0);
+  }
+
+  SECTION("A clock's slot is not taken from a live driver, nor released by another process") {
+    auto* robot_1 = registry->claim("robot_1", 1000);
+    REQUIRE(robot_1 != nullptr);
+    REQUIRE(registry->claim("robot_1", 1000) == nullptr);
+    REQUIRE(reap(spawn([registry, robot_1] {
+      registry->release(robot_1);
+      return registry->claim("robot_1", 1000) == nullptr;
+    })));
+    REQUIRE(registry->find("robot_1") == robot_1);
+  }
+
+  SECTION("Claims fail when full or the name is too long") {
+    for (auto i = 0U; i < Registry::NUM_SLOTS; ++i) {
+      REQUIRE(registry->claim("robot_" + std::to_string(i), 1000) != nullptr);
+    }
+    REQUIRE(registry->claim("one_too_many", 1000) == nullptr);
+    REQUIRE(registry->claim(std::string(Registry::MAX_NAME_LENGTH + 1, 'x'), 1000) == nullptr);
+  }
+
+  SECTION("Slots of drivers that died are taken over once none is free") {
+    // A driver process claims every slot, and exits without releasing them
+    REQUIRE(reap(spawn([registry] {
+      for (auto i = 0U; i < Registry::NUM_SLOTS; ++i) {
+        std::ignore = registry->claim("dead_" + std::to_string(i), 1000);
+      }
+      return true;
+    })));
+
+    const auto num_dead_found = [registry] {
+      auto count = 0U;
+      for (auto i = 0U; i < Registry::NUM_SLOTS; ++i) {
+        count += (registry->find("dead_" + std::to_string(i)) != nullptr) ? 1U : 0U;
+      }
+      return count;
+    };
+    REQUIRE(num_dead_found() == Registry::NUM_SLOTS);
+    auto* robot_1 = registry->claim("robot_1", 1000);
+    REQUIRE(robot_1 != nullptr);
+    REQUIRE(registry->find("robot_1") == robot_1);
+    REQUIRE(num_dead_found() == Registry::NUM_SLOTS - 1);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("EgoClock2 operation with clocks in a registry", "[ego_clock2]") {
+  using namespace std::chrono_literals;
+
+  static constexpr auto REGISTRY_NAME = "/grape_test_ego_clock2_registry";
+  static constexpr auto NUM_CLOCKS = 4;
+  static constexpr auto TICK_PERIOD = 10ms;
+
+  // Without driver, create() should time out
+  REQUIRE_FALSE(grape::EgoClock2::create("robot_0", 10ms, REGISTRY_NAME));
+
+  // One driver thread per clock, each running its clock at a different rate
+  const auto driver_thread = [](const std::stop_token& st, const std::string& clock_name,
+                                int speed) {
+    try {
+      const auto config = grape::EgoClock2Driver::Config{ .clock_name = clock_name,
+                                                          .registry_name = REGISTRY_NAME };
+      auto driver = grape::EgoClock2Driver(config);
+      auto ego_time = grape::EgoClock2::TimePoint{};
+      while (not st.stop_requested()) {
+        ego_time += speed * TICK_PERIOD;
+        driver.tick(ego_time);
+        std::this_thread::sleep_for(TICK_PERIOD);
+      }
+    } catch (...) {
+      grape::Exception::print();
+    }
+  };
+
+  auto drivers = std::vector<std::jthread>{};
+  for (auto i = 0; i < NUM_CLOCKS; ++i) {
+    drivers.emplace_back(driver_thread, "robot_" + std::to_string(i), i + 1);
+  }
+
+  auto clocks = std::vector<grape::EgoClock2>{};
+  for (auto i = 0; i < NUM_CLOCKS; ++i) {
+    const auto clock_name = "robot_" + std::to_string(i);
+    auto maybe_clock = grape::EgoClock2::create(clock_name, 2000ms, REGISTRY_NAME);
+    REQUIRE(maybe_clock);
+    clocks.push_back(std::move(maybe_clock.value()));
+  }
+
+  // Each clock follows its own driver
+  const auto start = clocks.back().now();
+  clocks.back().sleepFor(NUM_CLOCKS * 5 * TICK_PERIOD);
+  REQUIRE(clocks.back().now() >= start + NUM_CLOCKS * 5 * TICK_PERIOD);
+  REQUIRE(clocks.front().now() < clocks.back().now());
+
+  // Drivers don't remove the registry, as other drivers may still use it
+  clocks.clear();
+  drivers.clear();
+  shm_unlink(REGISTRY_NAME);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("EgoClock2 in a registry doesn't follow another clock reusing its slot", "[ego_clock2]") {
+  using namespace std::chrono_literals;
+
+  static constexpr auto REGISTRY_NAME = "/grape_test_ego_clock2_registry_reuse";
+  const auto config_of = [](const std::string& clock_name) {
+    return grape::EgoClock2Driver::Config{ .clock_name = clock_name,
+                                           .registry_name = REGISTRY_NAME };
+  };
+
+  auto driver_a = std::make_unique<grape::EgoClock2Driver>(config_of("robot_a"));
+  driver_a->tick(grape::EgoClock2::fromNanos(1000));
+  auto clock_a = grape::EgoClock2::create("robot_a", 100ms, REGISTRY_NAME);
+  REQUIRE(clock_a);
+  driver_a->tick(grape::EgoClock2::fromNanos(2000));
+  REQUIRE(clock_a->now() >= grape::EgoClock2::fromNanos(2000));
+  const auto last_a = clock_a->now();
+
+  // The slot released by robot_a is the first free one, so robot_b claims it
+  driver_a.reset();
+  auto driver_b = std::make_unique<grape::EgoClock2Driver>(config_of("robot_b"));
+  driver_b->tick(grape::EgoClock2::fromNanos(1'000'000'000));
+  auto clock_b = grape::EgoClock2::create("robot_b", 100ms, REGISTRY_NAME);
+  REQUIRE(clock_b);
+  REQUIRE(clock_b->now() >= grape::EgoClock2::fromNanos(1'000'000'000));
+
+  // robot_a stops where its driver left it, rather than jumping to robot_b's time
+  REQUIRE(clock_a->now() <= last_a);
+  REQUIRE_THROWS(clock_a->sleepUntil(grape::EgoClock2::fromNanos(3000)));
+
+  // ..and carries on once its driver runs again from that slot
+  driver_b.reset();
+  driver_a = std::make_unique<grape::EgoClock2Driver>(config_of("robot_a"));
+  driver_a->tick(grape::EgoClock2::fromNanos(5000));
+  REQUIRE(clock_a->now() >= grape::EgoClock2::fromNanos(5000));
+  REQUIRE_NOTHROW(clock_a->sleepUntil(grape::EgoClock2::fromNanos(5000)));
+
+  clock_a.reset();
+  clock_b.reset();
+  driver_a.reset();
+  shm_unlink(REGISTRY_NAME);
+}
+
 //-------------------------------------------------------------------------------------------------
 TEST_CASE("EgoClock2 operation with driver", "[ego_clock2]") {
   using namespace std::chrono_literals;
@@ -2,15 +2,20 @@
 // Copyright (C) 2025 GRAPE Contributors
 //=================================================================================================
 
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <optional>
 #include <thread>
 
+#include "../src/clock_topic.h"
 #include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
 #include "grape/ego_clock.h"
 #include "grape/ego_clock_driver.h"
 #include "grape/exception.h"
 #include "grape/ipc/session.h"
+#include "grape/ipc/subscriber.h"
 #include "grape/wall_clock.h"
 
 namespace {
@@ -128,6 +133,141 @@ TEST_CASE("EgoClock operation with master clock", "[ego_clock]") {
   REQUIRE(elapsed <= max_expected);
 }
 
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("EgoClock reports staleness when master clock stops", "[ego_clock]") {
+  using namespace std::chrono_literals;
+
+  grape::ipc::init({});
+
+  static constexpr auto TEST_CLOCK_NAME = "test_stale_clock";
+  static constexpr auto TICK_PERIOD = 10ms;
+
+  const auto master_clock = [](const std::stop_token& st, const std::string& clock_name) {
+    try {
+      const auto config = grape::EgoClockDriver::Config{ .clock_name = clock_name,
+                                                         .broadcast_interval = TICK_PERIOD,
+                                                         .calibration_window = 2U };
+      auto driver = grape::EgoClockDriver(config);
+      auto ego_time = grape::EgoClock::TimePoint{};
+      while (not st.stop_requested()) {
+        const auto wall_time = grape::WallClock::now();
+        driver.tick(ego_time, wall_time);
+        std::this_thread::sleep_until(wall_time + TICK_PERIOD);
+        ego_time += TICK_PERIOD;
+      }
+    } catch (...) {
+      grape::Exception::print();
+    }
+  };
+
+  auto master_clock_thread = std::jthread(master_clock, TEST_CLOCK_NAME);
+  auto maybe_clock = grape::EgoClock::create(TEST_CLOCK_NAME, 2000ms);
+  REQUIRE(maybe_clock);
+
+  // NOLINTBEGIN(bugprone-unchecked-optional-access)
+
+  // Fresh while the master is ticking
+  const auto fresh = maybe_clock->nowChecked();
+  REQUIRE_FALSE(fresh.isStale());
+  REQUIRE(fresh.sequence > 0U);
+  REQUIRE(fresh.uncertainty > 0ns);  // drifting since the fit, before it expires
+  std::this_thread::sleep_for(5 * TICK_PERIOD);
+  REQUIRE(maybe_clock->nowChecked().sequence > fresh.sequence);
+
+  // Stale a few broadcast periods after the master stops, with growing uncertainty
+  master_clock_thread.request_stop();
+  master_clock_thread.join();
+  std::this_thread::sleep_for(10 * TICK_PERIOD);
+  const auto stale1 = maybe_clock->nowChecked();
+  std::this_thread::sleep_for(10 * TICK_PERIOD);
+  const auto stale2 = maybe_clock->nowChecked();
+
+  // NOLINTEND(bugprone-unchecked-optional-access)
+
+  REQUIRE(stale1.isStale());
+  REQUIRE(stale2.staleness > stale1.staleness);
+  REQUIRE(stale2.uncertainty > stale1.uncertainty);
+  REQUIRE(stale2.sequence == stale1.sequence);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("EgoClockDriver transform stays exact over 7 days of ticks", "[ego_clock]") {
+  using namespace std::chrono_literals;
+
+  grape::ipc::init({});
+
+  static constexpr auto TEST_CLOCK_NAME = "test_week_clock";
+  static constexpr auto NUM_DAYS = 7;
+  static constexpr auto TICK_PERIOD = 1s;
+  static constexpr auto EGO_START_NS = 1'000'000'000'000LL;
+  static constexpr auto WALL_START_NS = 1'700'000'000'000'000'000LL;  // ~1.7e18 ns since 1970
+  static constexpr auto DRIFT_DIVISOR = 20'000LL;                      // wall runs 50 ppm fast
+
+  // True wall time of an ego time: exact in integers, as ticks are whole seconds
+  const auto wall_of = [](std::int64_t ego_ns) {
+    const auto dt = ego_ns - EGO_START_NS;
+    return grape::WallClock::fromNanos(WALL_START_NS + dt + (dt / DRIFT_DIVISOR));
+  };
+
+  auto mutex = std::mutex{};
+  auto latest = std::optional<grape::ego_clock::ClockTransform>{};
+  auto num_matched = std::atomic<int>{ 0 };
+  auto subscriber = grape::ipc::Subscriber<grape::ego_clock::ClockTopic>(
+      grape::ego_clock::ClockTopic(TEST_CLOCK_NAME),
+      [&](const auto& maybe_tf, const auto& /*info*/) {
+        if (maybe_tf) {
+          auto lock = std::lock_guard(mutex);
+          latest = *maybe_tf;
+        }
+      },
+      [&num_matched](const auto& /*match*/) { ++num_matched; });
+
+  // One broadcast a day, so that none is missed
+  const auto config = grape::EgoClockDriver::Config{ .clock_name = TEST_CLOCK_NAME,
+                                                     .broadcast_interval = 24h,
+                                                     .calibration_window = 100U };
+  auto driver = grape::EgoClockDriver(config);
+  for (auto i = 0; (num_matched == 0) and (i < 200); ++i) {
+    std::this_thread::sleep_for(10ms);
+  }
+  REQUIRE(num_matched > 0);
+
+  const auto ticks_per_day = std::chrono::nanoseconds(24h) / std::chrono::nanoseconds(TICK_PERIOD);
+  auto ego_ns = EGO_START_NS;
+  for (auto day = 1; day <= NUM_DAYS; ++day) {
+    for (auto i = 0; i < ticks_per_day; ++i) {
+      driver.tick(grape::EgoClock::fromNanos(ego_ns), wall_of(ego_ns));
+      ego_ns += std::chrono::nanoseconds(TICK_PERIOD).count();
+    }
+
+    // Wait for the day's broadcast
+    auto tf = std::optional<grape::ego_clock::ClockTransform>{};
+    for (auto i = 0; i < 200; ++i) {
+      {
+        auto lock = std::lock_guard(mutex);
+        if (latest and (latest->sequence == static_cast<std::uint64_t>(day))) {
+          tf = latest;
+          break;
+        }
+      }
+      std::this_thread::sleep_for(10ms);
+    }
+    REQUIRE(tf);
+
+    // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+    const auto transform = *tf;
+    const auto last_ego_ns = ego_ns - std::chrono::nanoseconds(TICK_PERIOD).count();
+    const auto wall_error = grape::ego_clock::toWallTime(
+                                transform, grape::EgoClock::fromNanos(last_ego_ns)) -
+                            wall_of(last_ego_ns);
+    REQUIRE(std::chrono::abs(wall_error) <= 2ns);
+    const auto ego_error =
+        grape::ego_clock::toEgoTime(transform, wall_of(last_ego_ns)) -
+        grape::EgoClock::fromNanos(last_ego_ns);
+    REQUIRE(std::chrono::abs(ego_error) <= 2ns);
+  }
+}
+
 //-------------------------------------------------------------------------------------------------
 TEST_CASE("EgoClock clock properties", "[ego_clock]") {
   REQUIRE_FALSE(grape::EgoClock::IS_STEADY);
@@ -2,6 +2,8 @@
 // Copyright (C) 2025 GRAPE Contributors
 //=================================================================================================
 
+#include <random>
+
 #include "../src/line_fitter.h"
 #include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
@@ -147,6 +149,178 @@ TEST_CASE("LineFitter with vertical variation", "[line_fitter]") {
   // But we should get here without crashing
 }
 
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Incremental mode matches batch mode", "[line_fitter]") {
+  using Mode = grape::ego_clock::LineFitter::Mode;
+  static constexpr auto WINDOW_SIZE = 16U;
+  static constexpr auto NUM_SAMPLES = 10'000U;
+  grape::ego_clock::LineFitter batch(WINDOW_SIZE, Mode::Batch);
+  grape::ego_clock::LineFitter incremental(WINDOW_SIZE, Mode::Incremental);
+
+  // y = 3x - 2 with noise, run long enough that every sample is added and evicted many times
+  auto gen = std::mt19937{ 42U };  // NOLINT(cert-msc32-c,cert-msc51-cpp) deterministic on purpose
+  auto noise = std::normal_distribution<>{ 0.0, 0.5 };
+  for (auto i = 0U; i < NUM_SAMPLES; ++i) {
+    const auto x = static_cast<double>(i) * 0.1;
+    const auto point =
+        grape::ego_clock::LineFitter::DataPoint{ .x = x, .y = (3. * x) - 2. + noise(gen) };
+    batch.add(point);
+    incremental.add(point);
+
+    // Compare predictions within the window rather than intercepts: both modes lose precision in
+    // the intercept as x moves away from 0, in different ways
+    const auto expected = batch.fit();
+    const auto actual = incremental.fit();
+    REQUIRE(expected.has_value() == actual.has_value());
+    if (expected) {
+      REQUIRE(actual->slope == Catch::Approx(expected->slope).epsilon(1e-6));
+      REQUIRE(std::fma(actual->slope, x, actual->intercept) ==
+              Catch::Approx(std::fma(expected->slope, x, expected->intercept)).epsilon(1e-9));
+      REQUIRE(actual->mse == Catch::Approx(expected->mse).epsilon(1e-6).margin(1e-9));
+    }
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Incremental mode is stable for nanosecond-scale x", "[line_fitter]") {
+  using Mode = grape::ego_clock::LineFitter::Mode;
+  static constexpr auto WINDOW_SIZE = 64U;
+  static constexpr auto NUM_SAMPLES = 100'000U;
+  static constexpr auto EPOCH_NS = 1.7e18;   // x: ego clock ticks, nanoseconds since epoch
+  static constexpr auto TICK_NS = 1e6;       // 1 kHz ticks
+  static constexpr auto DRIFT = 1. + 50e-6;  // 50 ppm fast
+  static constexpr auto OFFSET_NS = 3e9;     // y: wall clock, 3s ahead
+  grape::ego_clock::LineFitter fitter(WINDOW_SIZE, Mode::Incremental);
+
+  auto last_x = 0.;
+  for (auto i = 0U; i < NUM_SAMPLES; ++i) {
+    last_x = EPOCH_NS + (static_cast<double>(i) * TICK_NS);
+    fitter.add({ .x = last_x, .y = std::fma(DRIFT, last_x - EPOCH_NS, EPOCH_NS + OFFSET_NS) });
+  }
+
+  // Doubles near 1.7e18 are 256ns apart, so the samples themselves carry up to 128ns of rounding
+  // error. The fit should be limited by that, not by cancellation in the sums
+  const auto result = fitter.fit();
+  REQUIRE(result.has_value());
+  REQUIRE(result->slope == Catch::Approx(DRIFT).epsilon(1e-6));
+  const auto expected_y = std::fma(DRIFT, last_x - EPOCH_NS, EPOCH_NS + OFFSET_NS);
+  const auto predicted_y = std::fma(result->slope, last_x, result->intercept);
+  REQUIRE(std::abs(predicted_y - expected_y) < 1024.);
+
+  // The closed-form error cancels large sums, so it is only good to within a microsecond here
+  REQUIRE(std::sqrt(result->mse) < 1000.);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Fit stays exact over 7 days of nanosecond ticks", "[line_fitter]") {
+  using Mode = grape::ego_clock::LineFitter::Mode;
+  static constexpr auto WINDOW_SIZE = 100U;
+  static constexpr auto TICK_NS = std::int64_t{ 100'000'000 };  // 10 Hz
+  static constexpr auto DRIFT_NS_PER_TICK = std::int64_t{ 5'000 };  // 50 ppm fast
+  static constexpr auto TICKS_PER_DAY = std::int64_t{ 24 * 60 * 60 * 10 };
+  static constexpr auto NUM_DAYS = 7;
+  static constexpr auto EGO_START_NS = std::int64_t{ 1'700'000'000'000'000'000 };
+  static constexpr auto WALL_START_NS = EGO_START_NS + std::int64_t{ 3'000'000'000 };
+  static constexpr auto EXPECTED_SLOPE = 1. + (50e-6);
+
+  for (const auto mode : { Mode::Batch, Mode::Incremental }) {
+    grape::ego_clock::LineFitter fitter(WINDOW_SIZE, mode);
+
+    // Integer timestamps relative to the first tick, as fed by the clock driver
+    for (auto day = 1; day <= NUM_DAYS; ++day) {
+      auto last_x = 0.;
+      auto last_y = 0.;
+      for (auto i = (day - 1) * TICKS_PER_DAY; i < day * TICKS_PER_DAY; ++i) {
+        const auto ego_ns = EGO_START_NS + (i * TICK_NS);
+        const auto wall_ns = WALL_START_NS + (i * (TICK_NS + DRIFT_NS_PER_TICK));
+        last_x = static_cast<double>(ego_ns - EGO_START_NS);
+        last_y = static_cast<double>(wall_ns - WALL_START_NS);
+        fitter.add({ .x = last_x, .y = last_y });
+      }
+
+      const auto result = fitter.fit();
+      REQUIRE(result.has_value());
+      REQUIRE(result->slope == Catch::Approx(EXPECTED_SLOPE).epsilon(1e-12));
+      REQUIRE(std::abs(std::fma(result->slope, last_x, result->intercept) - last_y) < 1.);
+
+      // mse in incremental mode comes from differences of large sums, and can't resolve errors
+      // much below 1e-8 of the span of y over the window (10s here)
+      REQUIRE(std::sqrt(result->mse) < ((mode == Mode::Batch) ? 1. : 100.));
+    }
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Robust mode matches least squares on clean data", "[line_fitter]") {
+  using Mode = grape::ego_clock::LineFitter::Mode;
+  static constexpr auto WINDOW_SIZE = 32U;
+  grape::ego_clock::LineFitter batch(WINDOW_SIZE, Mode::Batch);
+  grape::ego_clock::LineFitter robust(WINDOW_SIZE, Mode::Robust);
+
+  REQUIRE_FALSE(robust.fit());
+  auto gen = std::mt19937{ 42U };  // NOLINT(cert-msc32-c,cert-msc51-cpp) deterministic on purpose
+  auto noise = std::normal_distribution<>{ 0.0, 0.1 };
+  for (auto i = 0U; i < WINDOW_SIZE; ++i) {
+    const auto x = static_cast<double>(i);
+    const auto point =
+        grape::ego_clock::LineFitter::DataPoint{ .x = x, .y = (2. * x) + 1. + noise(gen) };
+    batch.add(point);
+    robust.add(point);
+  }
+
+  const auto expected = batch.fit();
+  const auto actual = robust.fit();
+  REQUIRE(actual.has_value());
+  REQUIRE(actual->slope == Catch::Approx(expected->slope).margin(0.01));
+  REQUIRE(actual->intercept == Catch::Approx(expected->intercept).margin(0.1));
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Robust mode rejects spike outliers", "[line_fitter]") {
+  using Mode = grape::ego_clock::LineFitter::Mode;
+  static constexpr auto WINDOW_SIZE = 64U;
+  static constexpr auto SLOPE = 1. + 50e-6;
+  static constexpr auto TICK_NS = 1e6;
+  static constexpr auto SPIKE_NS = 5e6;  // e.g. a master that was descheduled for 5ms
+  grape::ego_clock::LineFitter batch(WINDOW_SIZE, Mode::Batch);
+  grape::ego_clock::LineFitter robust(WINDOW_SIZE, Mode::Robust);
+
+  // y = SLOPE.x with +-100ns of jitter, and a late tick every 16 samples
+  auto gen = std::mt19937{ 42U };  // NOLINT(cert-msc32-c,cert-msc51-cpp) deterministic on purpose
+  auto jitter = std::uniform_real_distribution<>{ -100., 100. };
+  for (auto i = 0U; i < WINDOW_SIZE; ++i) {
+    const auto x = static_cast<double>(i) * TICK_NS;
+    const auto spike = ((i % 16U) == 5U) ? SPIKE_NS : 0.;
+    const auto point =
+        grape::ego_clock::LineFitter::DataPoint{ .x = x, .y = (SLOPE * x) + jitter(gen) + spike };
+    batch.add(point);
+    robust.add(point);
+  }
+
+  const auto ols = batch.fit();
+  const auto result = robust.fit();
+  REQUIRE(result.has_value());
+
+  // least squares is pulled off by the spikes by more than a microsecond; robust fit is not
+  const auto last_x = static_cast<double>(WINDOW_SIZE - 1U) * TICK_NS;
+  const auto expected_y = SLOPE * last_x;
+  REQUIRE(std::abs(std::fma(ols->slope, last_x, ols->intercept) - expected_y) > 1000.);
+  REQUIRE(std::abs(std::fma(result->slope, last_x, result->intercept) - expected_y) < 100.);
+  REQUIRE(result->slope == Catch::Approx(SLOPE).epsilon(1e-6));
+  REQUIRE(std::sqrt(result->mse) < 1000.);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Robust mode with vertical variation", "[line_fitter]") {
+  grape::ego_clock::LineFitter fitter(4U, grape::ego_clock::LineFitter::Mode::Robust);
+  fitter.add({ .x = 5.0, .y = 1.0 });
+  fitter.add({ .x = 5.0, .y = 2.0 });
+  fitter.add({ .x = 5.0, .y = 3.0 });
+
+  // ill-conditioned, but we should get here without crashing
+  REQUIRE(fitter.fit().has_value());
+}
+
 // NOLINTEND(bugprone-unchecked-optional-access)
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
 
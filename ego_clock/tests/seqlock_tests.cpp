@@ -0,0 +1,120 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "../src/seqlock.h"
+#include "catch2/catch_test_macros.hpp"
+
+namespace {
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+/// Value spanning several words, so that a torn read shows up as fields that disagree
+struct Record {
+  std::array<std::uint64_t, 5> fields{};
+};
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("SeqLock starts uninitialised", "[seqlock]") {
+  const auto lock = grape::ego_clock::SeqLock<Record>{};
+  REQUIRE(lock.version() == 0U);
+  REQUIRE(lock.load().fields == Record{}.fields);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("SeqLock returns last stored value", "[seqlock]") {
+  auto lock = grape::ego_clock::SeqLock<Record>{};
+  lock.store({ .fields = { 1, 2, 3, 4, 5 } });
+  REQUIRE(lock.version() == 2U);
+  lock.store({ .fields = { 6, 7, 8, 9, 10 } });
+  REQUIRE(lock.version() == 4U);
+  REQUIRE(lock.load().fields == Record{ .fields = { 6, 7, 8, 9, 10 } }.fields);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("SeqLock readers never see torn values", "[seqlock]") {
+  static constexpr auto NUM_READERS = 4U;
+  static constexpr auto NUM_STORES = 200'000U;
+
+  auto lock = grape::ego_clock::SeqLock<Record>{};
+  auto done = std::atomic_bool{ false };
+  auto num_torn = std::atomic<std::size_t>{ 0U };
+  auto num_backwards = std::atomic<std::size_t>{ 0U };
+
+  auto readers = std::vector<std::jthread>{};
+  for (auto i = 0U; i < NUM_READERS; ++i) {
+    readers.emplace_back([&] {
+      auto last = 0UL;
+      while (not done.load(std::memory_order_relaxed)) {
+        const auto rec = lock.load();
+        for (const auto field : rec.fields) {
+          if (field != rec.fields.front()) {
+            ++num_torn;
+          }
+        }
+        if (rec.fields.front() < last) {
+          ++num_backwards;
+        }
+        last = rec.fields.front();
+      }
+    });
+  }
+
+  for (auto i = 1UL; i <= NUM_STORES; ++i) {
+    auto rec = Record{};
+    rec.fields.fill(i);
+    lock.store(rec);
+  }
+  done = true;
+  readers.clear();
+
+  REQUIRE(num_torn == 0U);
+  REQUIRE(num_backwards == 0U);
+  REQUIRE(lock.version() == 2U * NUM_STORES);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("SeqLock read() computes once, and only with values stored in full", "[seqlock]") {
+  static constexpr auto NUM_STORES = 200'000U;
+
+  auto lock = grape::ego_clock::SeqLock<Record>{};
+  auto done = std::atomic_bool{ false };
+  auto num_reads = 0UZ;
+  auto num_computed = 0UZ;
+  auto num_torn = 0UZ;
+
+  const auto check = [&](const Record& rec, std::uint64_t /*sample*/) {
+    ++num_computed;
+    for (const auto field : rec.fields) {
+      num_torn += (field != rec.fields.front()) ? 1U : 0U;
+    }
+    return rec.fields.front();
+  };
+  auto reader = std::jthread([&] {
+    while (not done.load(std::memory_order_relaxed)) {
+      ++num_reads;
+      std::ignore = lock.read([] { return std::uint64_t{ 0U }; }, check);
+    }
+  });
+
+  for (auto i = 1UL; i <= NUM_STORES; ++i) {
+    auto rec = Record{};
+    rec.fields.fill(i);
+    lock.store(rec);
+  }
+  done = true;
+  reader.join();
+
+  REQUIRE(num_torn == 0U);
+  REQUIRE(num_computed == num_reads);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+}  // namespace
@@ -0,0 +1,229 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/tick_log_format.h"
+#include "catch2/catch_test_macros.hpp"
+#include "grape/ego_clock2.h"
+#include "grape/ego_clock2_replay_driver.h"
+#include "grape/ego_clock_tick_log.h"
+
+namespace {
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+using grape::EgoClockTick;
+using grape::EgoClockTickLogReader;
+using grape::EgoClockTickLogWriter;
+
+//-------------------------------------------------------------------------------------------------
+// Path of a log file in the temp directory, removed on destruction
+struct TempLog {
+  explicit TempLog(const std::string& name)
+    : path(std::filesystem::temp_directory_path() / ("grape_" + name + ".ticks")) {
+    std::filesystem::remove(path);
+  }
+  ~TempLog() {
+    std::filesystem::remove(path);
+  }
+  TempLog(const TempLog&) = delete;
+  TempLog(TempLog&&) = delete;
+  auto operator=(const TempLog&) = delete;
+  auto operator=(TempLog&&) = delete;
+
+  std::filesystem::path path;
+};
+
+//-------------------------------------------------------------------------------------------------
+// Ticks 1 ms apart in ego time, with wall clock jitter, from ego time 'start_ns'
+auto makeTicks(std::size_t count, std::int64_t start_ns = 0) -> std::vector<EgoClockTick> {
+  auto ticks = std::vector<EgoClockTick>{};
+  static constexpr auto WALL_START_NS = 1'700'000'000'000'000'000LL;
+  static constexpr auto PERIOD_NS = 1'000'000LL;
+  for (auto i = 0LL; std::cmp_less(i, count); ++i) {
+    const auto jitter_ns = ((i * 7919) % 20'000) - 10'000;
+    ticks.push_back({ .ego_nanos = start_ns + (i * PERIOD_NS),
+                      .wall_nanos = WALL_START_NS + (i * PERIOD_NS) + jitter_ns });
+  }
+  return ticks;
+}
+
+//-------------------------------------------------------------------------------------------------
+auto writeTicks(const std::filesystem::path& path, const std::vector<EgoClockTick>& ticks) {
+  auto writer = EgoClockTickLogWriter(path.string());
+  for (const auto& tick : ticks) {
+    writer.append(tick);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+auto readTicks(const std::filesystem::path& path) -> std::vector<EgoClockTick> {
+  auto reader = EgoClockTickLogReader(path.string());
+  auto ticks = std::vector<EgoClockTick>{};
+  while (const auto tick = reader.next()) {
+    ticks.push_back(*tick);
+  }
+  return ticks;
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Varints round trip", "[tick_log]") {
+  using grape::ego_clock::decodeVarint;
+  using grape::ego_clock::encodeVarint;
+  using grape::ego_clock::zigzagDecode;
+  using grape::ego_clock::zigzagEncode;
+
+  static constexpr auto MIN = std::numeric_limits<std::int64_t>::min();
+  static constexpr auto MAX = std::numeric_limits<std::int64_t>::max();
+  const auto values = std::array<std::int64_t, 10>{ 0, 1, -1, 63, -64, 64, 1'000'000, -1'000'000,
+                                                    MIN, MAX };
+  for (const auto value : values) {
+    auto buffer = std::array<std::byte, grape::ego_clock::TickLogFormat::MAX_VARINT_BYTES>{};
+    const auto num_bytes = encodeVarint(zigzagEncode(value), buffer);
+    const auto decoded = decodeVarint(buffer);
+    REQUIRE(decoded.has_value());
+    REQUIRE(decoded->second == num_bytes);
+    REQUIRE(zigzagDecode(decoded->first) == value);
+
+    // A varint cut short isn't read
+    REQUIRE_FALSE(decodeVarint(std::span(buffer).first(num_bytes - 1U)).has_value());
+  }
+
+  auto buffer = std::array<std::byte, grape::ego_clock::TickLogFormat::MAX_VARINT_BYTES>{};
+  REQUIRE(encodeVarint(zigzagEncode(-64), buffer) == 1U);  // small changes either way, one byte
+  REQUIRE(encodeVarint(zigzagEncode(63), buffer) == 1U);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Ticks written to a log are read back", "[tick_log]") {
+  const auto log = TempLog("round_trip");
+  auto ticks = makeTicks(10'000);
+  ticks.push_back({ .ego_nanos = 0, .wall_nanos = ticks.back().wall_nanos + 1 });  // time reset
+  writeTicks(log.path, ticks);
+
+  REQUIRE(readTicks(log.path) == ticks);
+
+  // Ticks 1 ms apart take 6 bytes, after the first
+  const auto header_size = sizeof(grape::ego_clock::TickLogFormat::Header);
+  REQUIRE(std::filesystem::file_size(log.path) <= header_size + (6U * ticks.size()) + 30U);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Reader can start over", "[tick_log]") {
+  const auto log = TempLog("rewind");
+  const auto ticks = makeTicks(10);
+  writeTicks(log.path, ticks);
+
+  auto reader = EgoClockTickLogReader(log.path.string());
+  while (reader.next()) {
+  }
+  reader.rewind();
+  REQUIRE(reader.next() == ticks.front());
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Writing to an existing log appends to it", "[tick_log]") {
+  const auto log = TempLog("append");
+  const auto first = makeTicks(100);
+  const auto second = makeTicks(100, 1'000'000'000);
+  writeTicks(log.path, first);
+  writeTicks(log.path, second);
+
+  auto expected = first;
+  expected.insert(expected.end(), second.begin(), second.end());
+  REQUIRE(readTicks(log.path) == expected);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("A record cut short is ignored, and overwritten on appending", "[tick_log]") {
+  const auto log = TempLog("truncated");
+  const auto first = makeTicks(100);
+  writeTicks(log.path, first);
+  std::filesystem::resize_file(log.path, std::filesystem::file_size(log.path) - 1U);
+
+  const auto expected = std::vector(first.begin(), first.end() - 1);
+  REQUIRE(readTicks(log.path) == expected);
+
+  const auto second = makeTicks(10, 1'000'000'000);
+  writeTicks(log.path, second);
+  auto appended = expected;
+  appended.insert(appended.end(), second.begin(), second.end());
+  REQUIRE(readTicks(log.path) == appended);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Files that aren't tick logs are rejected", "[tick_log]") {
+  const auto log = TempLog("not_a_log");
+  {
+    auto file = std::ofstream(log.path);
+    file << "not a tick log at all";
+  }
+  REQUIRE_THROWS_AS(EgoClockTickLogReader(log.path.string()), std::runtime_error);
+  REQUIRE_THROWS_AS(EgoClockTickLogWriter(log.path.string()), std::runtime_error);
+  REQUIRE_THROWS_AS(EgoClockTickLogReader("/nonexistent/ticks"), std::runtime_error);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Replay driver posts recorded ticks", "[tick_log]") {
+  const auto log = TempLog("replay");
+  static constexpr auto NUM_TICKS = 10'000U;  // 10 s of recorded time
+  const auto ticks = makeTicks(NUM_TICKS, 1'000'000);
+  writeTicks(log.path, ticks);
+
+  const auto clock_name = std::string("/tick_log_replay_test");
+  const auto config = grape::EgoClock2ReplayDriver::Config{
+    .tick_log = log.path.string(), .driver = { .clock_name = clock_name }, .speed = 0.
+  };
+  auto replay = grape::EgoClock2ReplayDriver(config);
+
+  SECTION("As fast as possible") {
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(replay.run() == NUM_TICKS);
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+    REQUIRE(replay.run() == 0U);  // nothing left
+
+    // The clock shows the last tick, interpolated up to one tick period ahead
+    const auto clock = grape::EgoClock2::create(clock_name, std::chrono::seconds(1));
+    REQUIRE(clock.has_value());
+    const auto now_ns = grape::EgoClock2::toNanos(clock->now());
+    REQUIRE(now_ns >= ticks.back().ego_nanos);
+    REQUIRE(now_ns <= ticks.back().ego_nanos + 1'000'000);
+  }
+
+  SECTION("Stops when asked") {
+    auto stop = std::stop_source{};
+    stop.request_stop();
+    REQUIRE(replay.run(stop.get_token()) == 0U);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Replay driver paces ticks at a scaled rate", "[tick_log]") {
+  const auto log = TempLog("replay_paced");
+  writeTicks(log.path, makeTicks(101));  // 100 ms of recorded time
+
+  const auto config = grape::EgoClock2ReplayDriver::Config{
+    .tick_log = log.path.string(), .driver = { .clock_name = "/tick_log_paced_test" }, .speed = 5.
+  };
+  auto replay = grape::EgoClock2ReplayDriver(config);
+  const auto start = std::chrono::steady_clock::now();
+  REQUIRE(replay.run() == 101U);
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  REQUIRE(elapsed >= std::chrono::milliseconds(20));
+  REQUIRE(elapsed < std::chrono::milliseconds(200));
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+}  // namespace
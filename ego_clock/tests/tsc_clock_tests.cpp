@@ -0,0 +1,56 @@
+//=================================================================================================
+// Copyright (C) 2025 GRAPE Contributors
+//=================================================================================================
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "../src/tsc_clock.h"
+#include "catch2/catch_test_macros.hpp"
+
+namespace {
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+using grape::ego_clock::TscCalibration;
+using grape::ego_clock::TscClock;
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("TSC doesn't go backwards", "[tsc_clock]") {
+  if (not TscClock::isAvailable()) {
+    return;  // nothing to test on this machine
+  }
+  auto last = TscClock::now();
+  auto num_backwards = 0;
+  for (auto i = 0; i < 100'000; ++i) {
+    const auto ticks = TscClock::now();
+    if (ticks < last) {
+      ++num_backwards;
+    }
+    last = ticks;
+  }
+  REQUIRE(num_backwards == 0);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Calibrated TSC keeps time with the wall clock", "[tsc_clock]") {
+  if (not TscClock::isAvailable()) {
+    return;  // nothing to test on this machine
+  }
+  auto calibration = TscCalibration{};
+  REQUIRE(calibration.nsPerTick() > 0.);
+
+  const auto start = calibration.update();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const auto end = TscCalibration::sample();
+
+  // The initial estimate is made over 10 ms, so allow for a generous 0.5% error
+  const auto wall_elapsed = static_cast<double>(end.wall_ns - start.wall_ns);
+  const auto tsc_elapsed = static_cast<double>(end.ticks - start.ticks) * calibration.nsPerTick();
+  REQUIRE(std::abs(tsc_elapsed - wall_elapsed) < 0.005 * wall_elapsed);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+}  // namespace
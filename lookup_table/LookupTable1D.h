@@ -8,6 +8,19 @@
 
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+#if __cplusplus >= 202002L
+#include <span>
+#include <type_traits>
+#if __has_include(<experimental/simd>)
+#include <experimental/simd>
+#define LOOKUPTABLE1D_SIMD
+#endif
+#endif
 
 //==============================================================================
 /// \class LookupTable1D
@@ -20,6 +33,12 @@
 /// set by data points in the LUT, the returned value is just the upper or lower limit, 
 /// respectively; i.e. no extrapolation is performed.
 ///
+/// Independent and dependent variables are held in separate arrays, so that
+/// searching for x only touches x values. If the data points are equally spaced
+/// in x (either detected as they are inserted, or constructed that way), look-ups
+/// compute the index of the interval containing x instead of searching for it,
+/// which takes constant time however large the table.
+///
 /// Example Program:
 /// \include LookupTable1DTest.cpp
 //==============================================================================
@@ -29,11 +48,25 @@ class LookupTable1D
 {
 public:
     
+    /// Relative difference in spacing between data points up to which they
+    /// are still considered equally spaced. Differences within rounding error
+    /// of I at the magnitude of the data points are tolerated on top of this.
+    static const double UNIFORM_TOLERANCE;
+
     /// Create a LUT. At least two data points are required for this
     /// to be sensible. More data-pairs can be inserted later if required.
     /// \param (x0, y0) Data-pair 1, x is independent variable.
     /// \param (x1, y1) Data-pair 2, x is indepenedent variable.
     LookupTable1D(const I& x0, const D& y0, const I& x1, const D& y1);
+
+    /// Create a LUT with data points equally spaced in x.
+    /// \param x0 (input) Independent variable of the first data point.
+    /// \param dx (input) Spacing between data points. Must be positive.
+    /// \param y (input) Dependent variable at x0, x0 + dx, x0 + 2dx, etc. At
+    ///          least two values are required.
+    /// \throw std::invalid_argument if dx isn't positive or y has fewer than
+    ///        two values.
+    LookupTable1D(const I& x0, const I& dx, const std::vector<D>& y);
     
     ~LookupTable1D();
     
@@ -49,30 +82,88 @@ public:
     /// between closest data points on either side of x is returned.
     /// \param x (input) Independent variable.
     /// \return interpolated value for the dependent variable.
-    D lookup(const I& x);
+    D lookup(const I& x) const;
+
+#if __cplusplus >= 202002L
+    /// Look up for y at each of a batch of x, as lookup(x) does for one. For
+    /// tables of float or double, interpolation is done several x at a time
+    /// in SIMD registers. If x is in ascending order, as for samples of a
+    /// swept signal, the search for each interval starts from the last one.
+    /// \param x (input) Independent variables.
+    /// \param y (output) Interpolated values for the dependent variable, y[i]
+    ///          for x[i]. Must be at least as long as x.
+    void lookup(std::span<const I> x, std::span<D> y) const;
+#endif
+
+    /// \return true if data points are equally spaced, so that look-ups don't
+    /// need to search the table.
+    bool isUniform() const { return uniform_; }
     
 private:
-    struct CompareI //!< my comparison functor
-    {
-        bool operator()(const std::pair<I,D>& lhs, const I& rhs) { return lhs.first < rhs; } 
-    };
+    /// \return Index of the data point at the start of the interval containing x,
+    /// given x lies within the table
+    std::size_t findInterval(const I& x) const;
     
-    std::vector< std::pair<I,D> > dataPoints_;
+    /// \return Index of the data point at the start of the interval containing x,
+    /// given x lies within the table, searching forward from interval 'from'
+    std::size_t findIntervalFrom(const I& x, std::size_t from) const;
+
+#if __cplusplus >= 202002L
+    /// Look up for y at each x, given a function returning the interval
+    /// containing any x within the table
+    template <class IntervalFn>
+    void lookupBatch(std::span<const I> x, std::span<D> y, IntervalFn interval) const;
+
+    /// Look up for y at as many x as fill whole SIMD registers, given data
+    /// points are equally spaced, computing the interval of each x from its
+    /// distance to the first data point
+    /// \return Number of x looked up, from the start
+    std::size_t lookupUniform(std::span<const I> x, std::span<D> y) const;
+#endif
+
+    /// Check whether data points are equally spaced, and set up indexing if they are
+    void updateUniform();
+
+    std::vector<I> x_; //!< independent variable, in ascending order
+    std::vector<D> y_; //!< dependent variable, y_[i] at x_[i]
+
+    bool uniform_;  //!< data points are equally spaced in x
+    double invDx_;  //!< 1 / spacing between data points, if uniform_
     
 }; // LookupTable
 
-
+template <class I, class D>
+const double LookupTable1D<I,D>::UNIFORM_TOLERANCE = 1e-9;
 
     
 //------------------------------------------------------------------------------
 template <class I, class D>
 LookupTable1D<I,D>::LookupTable1D(const I& x0, const D& y0, const I& x1, const D& y1)
 //------------------------------------------------------------------------------
+: uniform_(false), invDx_(0)
 {
     insertDataPoint(x0, y0);
     insertDataPoint(x1, y1);
 }
 
+//------------------------------------------------------------------------------
+template <class I, class D>
+LookupTable1D<I,D>::LookupTable1D(const I& x0, const I& dx, const std::vector<D>& y)
+//------------------------------------------------------------------------------
+: y_(y), uniform_(true), invDx_(1.0 / static_cast<double>(dx))
+{
+    if( !(dx > 0) || y.size() < 2 )
+    {
+        throw std::invalid_argument("LookupTable1D: equally spaced data points need dx > 0 and at least two values");
+    }
+
+    x_.reserve(y.size());
+    for( std::size_t i = 0; i < y.size(); ++i )
+    {
+        x_.push_back( x0 + static_cast<I>(i) * dx );
+    }
+}
+
 //------------------------------------------------------------------------------
 template <class I, class D>
 LookupTable1D<I,D>::~LookupTable1D()
@@ -85,47 +176,276 @@ template <class I, class D>
 void LookupTable1D<I,D>::insertDataPoint(const I& x, const D& y)
 //------------------------------------------------------------------------------
 {
-    typename std::vector< std::pair<I,D> >::const_iterator itEnd = dataPoints_.end();
-    typename std::vector< std::pair<I,D> >::iterator it = std::lower_bound( dataPoints_.begin(), dataPoints_.end(), x, CompareI() );
+    const std::size_t i = std::lower_bound( x_.begin(), x_.end(), x ) - x_.begin();
+    x_.insert( x_.begin() + i, x );
+    y_.insert( y_.begin() + i, y );
+    updateUniform();
+}
+
+//------------------------------------------------------------------------------
+template <class I, class D>
+void LookupTable1D<I,D>::updateUniform()
+//------------------------------------------------------------------------------
+{
+    uniform_ = false;
+    if( x_.size() < 2 )
+    {
+        return;
+    }
     
-    if( it != itEnd )
+    const double dx = static_cast<double>(x_.back() - x_.front()) / static_cast<double>(x_.size() - 1);
+    if( !(dx > 0) )
     {
-        dataPoints_.insert( it, std::pair<I,D>(x, y) );
+        return;
     }
-    else
+
+    // data points of type float, say, are only equally spaced to within float rounding
+    const double magnitude = std::max( std::fabs( static_cast<double>(x_.front()) ), std::fabs( static_cast<double>(x_.back()) ) );
+    const double rounding = 4.0 * static_cast<double>( std::numeric_limits<I>::epsilon() ) * magnitude;
+    const double tolerance = UNIFORM_TOLERANCE * dx + rounding;
+
+    for( std::size_t i = 1; i < x_.size(); ++i )
     {
-        dataPoints_.push_back( std::pair<I,D>(x, y) );
+        if( std::fabs( static_cast<double>(x_[i] - x_[i-1]) - dx ) > tolerance )
+        {
+            return;
+        }
     }
+    uniform_ = true;
+    invDx_ = 1.0 / dx;
 }
 
 //------------------------------------------------------------------------------
 template <class I, class D>
-D LookupTable1D<I,D>::lookup(const I& x)
+std::size_t LookupTable1D<I,D>::findInterval(const I& x) const
+//------------------------------------------------------------------------------
+{
+    if( uniform_ )
+    {
+        // clamp, as rounding can put x just past either end
+        std::size_t i = std::min( static_cast<std::size_t>( static_cast<double>(x - x_.front()) * invDx_ ), x_.size() - 2 );
+
+        // data points are only equally spaced to within a tolerance, so x may lie
+        // just across a data point from the interval computed. Step to the one
+        // a search would find.
+        if( !(x_[i] < x) )
+        {
+            --i;
+        }
+        else if( x_[i+1] < x )
+        {
+            ++i;
+        }
+        return i;
+    }
+    return std::lower_bound( x_.begin(), x_.end(), x ) - x_.begin() - 1;
+}
+
+//------------------------------------------------------------------------------
+template <class I, class D>
+std::size_t LookupTable1D<I,D>::findIntervalFrom(const I& x, std::size_t from) const
+//------------------------------------------------------------------------------
+{
+    // x went back, so search the whole table
+    if( !(x_[from] < x) )
+    {
+        return findInterval(x);
+    }
+
+    // step forward in growing strides until past x, then search the last stride
+    std::size_t lo = from;
+    std::size_t step = 1;
+    while( lo + step < x_.size() && x_[lo + step] < x )
+    {
+        lo += step;
+        step *= 2;
+    }
+    const std::size_t hi = std::min( lo + step, x_.size() - 1 );
+    return std::lower_bound( x_.begin() + lo + 1, x_.begin() + hi + 1, x ) - x_.begin() - 1;
+}
+
+//------------------------------------------------------------------------------
+template <class I, class D>
+D LookupTable1D<I,D>::lookup(const I& x) const
 //------------------------------------------------------------------------------
 {
-    typename std::vector< std::pair<I,D> >::const_iterator itBegin = dataPoints_.begin();
-    typename std::vector< std::pair<I,D> >::const_iterator itEnd = dataPoints_.end();
-    typename std::vector< std::pair<I,D> >::const_iterator it = std::lower_bound( dataPoints_.begin(), dataPoints_.end(), x, CompareI() );
-    
     // if 'x' is below lower limit, clip to lower limit (don't extrapolate)
-    if (it == itBegin )
+    if( !(x > x_.front()) )
     {
-        return dataPoints_.front().second;
+        return y_.front();
     }
     
     // if 'x' is above upper limit, clip to upper limit (don't extrapolate)
-    else if( it == itEnd )
+    else if( !(x < x_.back()) )
     {
-        return dataPoints_.back().second;
+        return y_.back();
     }
 
     // interpolate
     else
     {
         // y = y0 + [ (x - x0) * (y1 - y0)/(x1 - x0)]
-        return (it-1)->second + (x - (it-1)->first) * ( it->second - (it-1)->second ) / ( it->first - (it-1)->first );
+        const std::size_t i = findInterval(x);
+        return y_[i] + (x - x_[i]) * ( y_[i+1] - y_[i] ) / ( x_[i+1] - x_[i] );
+    }
+}
+
+#if __cplusplus >= 202002L
+
+//------------------------------------------------------------------------------
+template <class I, class D>
+void LookupTable1D<I,D>::lookup(std::span<const I> x, std::span<D> y) const
+//------------------------------------------------------------------------------
+{
+    const auto interval = [this](const I& xi) { return findInterval(xi); };
+    if( uniform_ )
+    {
+        const std::size_t n = lookupUniform( x, y );
+        lookupBatch( x.subspan(n), y.subspan(n), interval );
+    }
+    else if( !std::is_sorted( x.begin(), x.end() ) )
+    {
+        lookupBatch( x, y, interval );
+    }
+    else
+    {
+        // intervals only move forward
+        std::size_t cursor = 0;
+        lookupBatch( x, y, [this, &cursor](const I& xi) { return cursor = findIntervalFrom(xi, cursor); } );
+    }
+}
+
+//------------------------------------------------------------------------------
+template <class I, class D>
+template <class IntervalFn>
+void LookupTable1D<I,D>::lookupBatch(std::span<const I> x, std::span<D> y, IntervalFn interval) const
+//------------------------------------------------------------------------------
+{
+    // interval for any x, clipped to the first or last one outside the table
+    const auto clippedInterval = [this, &interval](const I& xi) -> std::size_t
+    {
+        if( !(xi > x_.front()) )
+        {
+            return 0;
+        }
+        if( !(xi < x_.back()) )
+        {
+            return x_.size() - 2;
+        }
+        return interval(xi);
+    };
+
+    std::size_t j = 0;
+
+#ifdef LOOKUPTABLE1D_SIMD
+    if constexpr( std::is_same_v<I, D> && std::is_floating_point_v<D> )
+    {
+        namespace stdx = std::experimental;
+        using Simd = stdx::native_simd<D>;
+        constexpr std::size_t N = Simd::size();
+
+        for( ; j + N <= x.size(); j += N )
+        {
+            std::size_t i[N];
+            for( std::size_t k = 0; k < N; ++k )
+            {
+                i[k] = clippedInterval( x[j + k] );
+            }
+
+            // y = y0 + [ (x - x0) * (y1 - y0)/(x1 - x0)]
+            const Simd xs( &x[j], stdx::element_aligned );
+            const Simd x0( [&](auto k) { return x_[i[k]]; } );
+            const Simd x1( [&](auto k) { return x_[i[k] + 1]; } );
+            const Simd y0( [&](auto k) { return y_[i[k]]; } );
+            const Simd y1( [&](auto k) { return y_[i[k] + 1]; } );
+            Simd ys = y0 + (xs - x0) * ( y1 - y0 ) / ( x1 - x0 );
+
+            // clip to the limits (don't extrapolate), lower limit first as lookup(x) does
+            stdx::where( !(xs < x_.back()), ys ) = y_.back();
+            stdx::where( !(xs > x_.front()), ys ) = y_.front();
+            ys.copy_to( &y[j], stdx::element_aligned );
+        }
+    }
+#endif
+
+    for( ; j < x.size(); ++j )
+    {
+        if( !(x[j] > x_.front()) )
+        {
+            y[j] = y_.front();
+        }
+        else if( !(x[j] < x_.back()) )
+        {
+            y[j] = y_.back();
+        }
+        else
+        {
+            const std::size_t i = interval(x[j]);
+            y[j] = y_[i] + (x[j] - x_[i]) * ( y_[i+1] - y_[i] ) / ( x_[i+1] - x_[i] );
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+template <class I, class D>
+std::size_t LookupTable1D<I,D>::lookupUniform(std::span<const I> x, std::span<D> y) const
+//------------------------------------------------------------------------------
+{
+    std::size_t j = 0;
+
+#ifdef LOOKUPTABLE1D_SIMD
+    if constexpr( std::is_same_v<I, D> && std::is_floating_point_v<D> )
+    {
+        namespace stdx = std::experimental;
+        using Simd = stdx::native_simd<D>;
+        using Index = stdx::rebind_simd_t<int, Simd>;
+        constexpr std::size_t N = Simd::size();
+
+        const Simd lastInterval = static_cast<D>( x_.size() - 2 );
+        for( ; j + N <= x.size(); j += N )
+        {
+            // interval from the position of x in units of spacing from the first data point
+            const Simd xs( &x[j], stdx::element_aligned );
+            const auto below = !(xs > x_.front());
+            const auto above = !(xs < x_.back());
+            Simd t = (xs - x_.front()) * static_cast<D>(invDx_);
+            stdx::where( below || above, t ) = 0;
+            const Index i = stdx::static_simd_cast<Index>( stdx::min( t, lastInterval ) );
+
+            // y = y0 + [ (x - x0) * (y1 - y0)/(x1 - x0)], between the data points as stored
+            const Simd x0( [&](auto k) { return x_[i[k]]; } );
+            const Simd x1( [&](auto k) { return x_[i[k] + 1]; } );
+            const Simd y0( [&](auto k) { return y_[i[k]]; } );
+            const Simd y1( [&](auto k) { return y_[i[k] + 1]; } );
+            Simd ys = y0 + (xs - x0) * ( y1 - y0 ) / ( x1 - x0 );
+
+            // clip to the limits (don't extrapolate), lower limit first as lookup(x) does
+            stdx::where( above, ys ) = y_.back();
+            stdx::where( below, ys ) = y_.front();
+            ys.copy_to( &y[j], stdx::element_aligned );
+
+            // t is rounded to D, and data points are only equally spaced to within
+            // a tolerance, so x may lie just across a data point from the interval
+            // computed. Look those x up one at a time.
+            const auto across = !(below || above) && ( !(x0 < xs) || x1 < xs );
+            if( stdx::any_of(across) )
+            {
+                for( std::size_t k = 0; k < N; ++k )
+                {
+                    if( across[k] )
+                    {
+                        y[j + k] = lookup( x[j + k] );
+                    }
+                }
+            }
+        }
     }
+#endif
+
+    return j;
 }
 
+#endif
+
 #endif	// LOOKUPTABLE1D_H
 
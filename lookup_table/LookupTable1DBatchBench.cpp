@@ -0,0 +1,130 @@
+//==============================================================================
+/// \file        LookupTable1DBatchBench.cpp
+/// \brief       Benchmark of batch look-ups in a 1D LUT against a scalar loop
+///
+/// Maps frames of samples through tables of equally and unequally spaced
+/// data points, with samples in random and in ascending order, one at a time
+/// with lookup(x) and all at once with lookup(x, y). Prints throughput in
+/// millions of samples per second.
+///
+/// A stand-alone program, separate from the test program in main.cpp:
+/// g++ -O3 -std=c++23 -o LookupTable1DBatchBench LookupTable1DBatchBench.cpp
+//==============================================================================
+
+#include "LookupTable1D.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace
+{
+
+static const std::size_t FRAME_SIZE = 4096;
+static const std::size_t NUM_FRAMES = 256;
+
+//==============================================================================
+/// \return Throughput in millions of samples per second, of the best of a few
+/// runs of lookupFrame over all frames
+template <class LookupFrame>
+double timeFrames(const std::vector< std::vector<double> >& frames, std::vector<double>& out, LookupFrame lookupFrame)
+//==============================================================================
+{
+    static const int REPEATS = 5;
+    double best = 0;
+    for( int r = 0; r < REPEATS; ++r )
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for( std::size_t f = 0; f < frames.size(); ++f )
+        {
+            lookupFrame( frames[f], out );
+        }
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::max( best, static_cast<double>(frames.size() * FRAME_SIZE) / elapsed.count() );
+    }
+    return best;
+}
+
+//==============================================================================
+/// Print throughput of the scalar loop and of batch look-ups, for a table and frames
+void benchmark(const char* name, const LookupTable1D<double, double>& table, const std::vector< std::vector<double> >& frames)
+//==============================================================================
+{
+    std::vector<double> out(FRAME_SIZE);
+    double sum = 0; // keeps look-ups from being optimised away
+
+    const double scalar = timeFrames( frames, out,
+        [&table, &sum](const std::vector<double>& x, std::vector<double>& y)
+        {
+            for( std::size_t i = 0; i < x.size(); ++i )
+            {
+                y[i] = table.lookup(x[i]);
+            }
+            sum += y.back();
+        });
+    const double batch = timeFrames( frames, out,
+        [&table, &sum](const std::vector<double>& x, std::vector<double>& y)
+        {
+            table.lookup( std::span<const double>(x), std::span<double>(y) );
+            sum += y.back();
+        });
+
+    std::printf("%-28s %12.1f %12.1f %8.2fx  (checksum %g)\n", name, scalar, batch, batch / scalar, sum);
+}
+
+} // namespace
+
+//==============================================================================
+int main()
+//==============================================================================
+{
+    static const std::size_t SIZES[] = { 64, 4096, 65536 };
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> unit(0, 1);
+
+    std::printf("%-28s %12s %12s %9s  (Msamples/s)\n", "table / samples", "scalar", "batch", "speed-up");
+    for( std::size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); ++s )
+    {
+        const std::size_t n = SIZES[s];
+        std::vector<double> y(n);
+        for( std::size_t i = 0; i < n; ++i )
+        {
+            y[i] = unit(rng);
+        }
+
+        // the same table, with one point nudged so that it's searched for intervals
+        LookupTable1D<double, double> uniform(0, 1, y);
+        LookupTable1D<double, double> nonUniform(0, y[0], 1 + 1e-3, y[1]);
+        for( std::size_t i = 2; i < n; ++i )
+        {
+            nonUniform.insertDataPoint(static_cast<double>(i), y[i]);
+        }
+
+        // samples spread over the table and a little beyond it
+        std::vector< std::vector<double> > randomFrames(NUM_FRAMES, std::vector<double>(FRAME_SIZE));
+        std::vector< std::vector<double> > sortedFrames(NUM_FRAMES);
+        for( std::size_t f = 0; f < NUM_FRAMES; ++f )
+        {
+            for( std::size_t i = 0; i < FRAME_SIZE; ++i )
+            {
+                randomFrames[f][i] = (1.02 * unit(rng) - 0.01) * static_cast<double>(n - 1);
+            }
+            sortedFrames[f] = randomFrames[f];
+            std::sort( sortedFrames[f].begin(), sortedFrames[f].end() );
+        }
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "%zu uniform / random", n);
+        benchmark( name, uniform, randomFrames );
+        std::snprintf(name, sizeof(name), "%zu uniform / sorted", n);
+        benchmark( name, uniform, sortedFrames );
+        std::snprintf(name, sizeof(name), "%zu non-uniform / random", n);
+        benchmark( name, nonUniform, randomFrames );
+        std::snprintf(name, sizeof(name), "%zu non-uniform / sorted", n);
+        benchmark( name, nonUniform, sortedFrames );
+    }
+    return 0;
+}
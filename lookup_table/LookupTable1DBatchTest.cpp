@@ -0,0 +1,121 @@
+//==============================================================================
+/// \file        LookupTable1DBatchTest.cpp
+/// \brief       Test program for batch look-ups in LookupTable1D
+///
+/// Checks that looking up a batch of x gives the same values as looking up
+/// each x on its own, for float and double tables, equally spaced or not, with
+/// x in random and in ascending order. Requires C++20.
+//==============================================================================
+
+#include "LookupTable1D.h"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace
+{
+
+//==============================================================================
+/// \return Number of x for which a batch look-up differs from lookup(x)
+template <class T>
+std::size_t countMismatches(const LookupTable1D<T, T>& table, const std::vector<T>& x)
+//==============================================================================
+{
+    std::vector<T> y(x.size());
+    table.lookup( std::span<const T>(x), std::span<T>(y) );
+
+    std::size_t mismatches = 0;
+    for( std::size_t i = 0; i < x.size(); ++i )
+    {
+        if( y[i] != table.lookup(x[i]) )
+        {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+//==============================================================================
+/// Compare batch and single look-ups for a table with segments rising or
+/// falling by up to 1000, at random x over the table and a little beyond it,
+/// and at the same x sorted.
+/// \return true if all agree
+template <class T>
+bool checkTable(const char* name, const LookupTable1D<T, T>& table, T x0, T x1, std::mt19937& rng)
+//==============================================================================
+{
+    std::uniform_real_distribution<T> dist( x0 - (x1 - x0) / 100, x1 + (x1 - x0) / 100 );
+    std::vector<T> x(100000);
+    for( std::size_t i = 0; i < x.size(); ++i )
+    {
+        x[i] = dist(rng);
+    }
+
+    const std::size_t random = countMismatches(table, x);
+    std::sort( x.begin(), x.end() );
+    const std::size_t sorted = countMismatches(table, x);
+
+    std::cout << name << ": " << random << " mismatches at random x, "
+              << sorted << " at sorted x" << std::endl;
+    return random == 0 && sorted == 0;
+}
+
+//==============================================================================
+/// \return A table of n data points dx apart, either constructed as equally
+/// spaced or with points inserted one at a time
+template <class T>
+LookupTable1D<T, T> makeTable(std::size_t n, T dx, bool insert, std::mt19937& rng)
+//==============================================================================
+{
+    std::uniform_real_distribution<T> rise(-1000, 1000);
+    std::vector<T> y(n);
+    for( std::size_t i = 1; i < n; ++i )
+    {
+        y[i] = y[i-1] + rise(rng);
+    }
+    if( !insert )
+    {
+        return LookupTable1D<T, T>(0, dx, y);
+    }
+
+    LookupTable1D<T, T> table(0, y[0], dx, y[1]);
+    for( std::size_t i = 2; i < n; ++i )
+    {
+        table.insertDataPoint(static_cast<T>(i) * dx, y[i]);
+    }
+    return table;
+}
+
+} // namespace
+
+//==============================================================================
+int LookupTable1DBatchTest(int argc, char** argv)
+//==============================================================================
+{
+    std::mt19937 rng(1);
+    bool ok = true;
+
+    const LookupTable1D<float, float> floatWide = makeTable<float>(65536, 0.1f, false, rng);
+    ok = checkTable("float, 64K points 0.1 apart", floatWide, 0.f, 6553.5f, rng) && ok;
+
+    const LookupTable1D<float, float> floatFine = makeTable<float>(4096, 0.01f, false, rng);
+    ok = checkTable("float, 4K points 0.01 apart", floatFine, 0.f, 40.95f, rng) && ok;
+
+    const LookupTable1D<float, float> floatInserted = makeTable<float>(64, 0.1f, true, rng);
+    ok = checkTable("float, 64 points inserted 0.1 apart", floatInserted, 0.f, 6.3f, rng) && ok;
+    ok = floatInserted.isUniform() && ok;
+
+    const LookupTable1D<double, double> doubleWide = makeTable<double>(65536, 0.1, false, rng);
+    ok = checkTable("double, 64K points 0.1 apart", doubleWide, 0., 6553.5, rng) && ok;
+
+    // one point nudged, so that intervals are searched for
+    LookupTable1D<float, float> floatSearched = makeTable<float>(4096, 0.01f, true, rng);
+    floatSearched.insertDataPoint(0.005f, 0.f);
+    ok = checkTable("float, 4K points unequally spaced", floatSearched, 0.f, 40.95f, rng) && ok;
+
+    std::cout << (ok ? "Batch look-ups passed" : "Batch look-ups FAILED") << std::endl;
+    return ok ? 0 : -1;
+}
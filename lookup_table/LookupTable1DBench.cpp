@@ -0,0 +1,184 @@
+//==============================================================================
+/// \file        LookupTable1DBench.cpp
+/// \brief       Benchmark of searches for the interval containing x in a 1D LUT
+///
+/// Times look-ups at random x in tables of 8 to 64K data points, finding the
+/// interval by:
+/// - binary search over (x, y) pairs, as LookupTable1D used to store them
+/// - binary search over x alone (LookupTable1D with unequally spaced points)
+/// - index computed from x (LookupTable1D with equally spaced points)
+/// - branchless search over x in Eytzinger (breadth-first) order
+///
+/// A stand-alone program, separate from the test program in main.cpp:
+/// g++ -O2 -o LookupTable1DBench LookupTable1DBench.cpp
+//==============================================================================
+
+#include "LookupTable1D.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+//==============================================================================
+/// Look-up by binary search over (x, y) pairs
+class PairTable
+{
+public:
+    PairTable(const std::vector<double>& x, const std::vector<double>& y)
+    {
+        for( std::size_t i = 0; i < x.size(); ++i )
+        {
+            table_.push_back( std::make_pair(x[i], y[i]) );
+        }
+    }
+
+    double lookup(double x) const
+    {
+        if( !(x > table_.front().first) )
+        {
+            return table_.front().second;
+        }
+        if( !(x < table_.back().first) )
+        {
+            return table_.back().second;
+        }
+        std::vector< std::pair<double, double> >::const_iterator it =
+            std::lower_bound( table_.begin(), table_.end(), std::make_pair(x, -1e300) );
+        std::vector< std::pair<double, double> >::const_iterator prev = it - 1;
+        return prev->second + (x - prev->first) * (it->second - prev->second) / (it->first - prev->first);
+    }
+
+private:
+    std::vector< std::pair<double, double> > table_;
+};
+
+//==============================================================================
+/// Look-up by branchless search over x stored in Eytzinger order: the root
+/// of the search tree first, then its children, and so on. The top levels of
+/// the tree share a few cache lines, and the search has no branch to mispredict.
+class EytzingerTable
+{
+public:
+    EytzingerTable(const std::vector<double>& x, const std::vector<double>& y)
+    : x_(x), y_(y), tree_(x.size() + 1), index_(x.size() + 1)
+    {
+        std::size_t next = 0;
+        build(1, next);
+    }
+
+    double lookup(double x) const
+    {
+        if( !(x > x_.front()) )
+        {
+            return y_.front();
+        }
+        if( !(x < x_.back()) )
+        {
+            return y_.back();
+        }
+
+        // descend to a leaf, then back up to the last node where the search went left
+        std::size_t k = 1;
+        const std::size_t n = tree_.size() - 1;
+        while( k <= n )
+        {
+            k = 2 * k + (tree_[k] < x);
+        }
+        k >>= __builtin_ffsl( static_cast<long>(~k) );
+
+        const std::size_t i = index_[k] - 1;
+        return y_[i] + (x - x_[i]) * (y_[i+1] - y_[i]) / (x_[i+1] - x_[i]);
+    }
+
+private:
+    /// Fill the subtree at node k in order, with x from x_[next] onwards
+    void build(std::size_t k, std::size_t& next)
+    {
+        if( k < tree_.size() )
+        {
+            build(2 * k, next);
+            tree_[k] = x_[next];
+            index_[k] = next++;
+            build(2 * k + 1, next);
+        }
+    }
+
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> tree_;        //!< x in Eytzinger order, from tree_[1]
+    std::vector<std::size_t> index_;  //!< position in x_ of tree_[k]
+};
+
+//==============================================================================
+/// \return Average time per look-up in ns, over all queries
+template <class Table>
+double timeLookups(const Table& table, const std::vector<double>& queries, double& sum)
+//==============================================================================
+{
+    static const int REPEATS = 5;
+    double best = 1e300;
+    for( int r = 0; r < REPEATS; ++r )
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for( std::size_t i = 0; i < queries.size(); ++i )
+        {
+            sum += table.lookup(queries[i]);
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min( best, elapsed.count() / static_cast<double>(queries.size()) );
+    }
+    return best;
+}
+
+} // namespace
+
+//==============================================================================
+int main()
+//==============================================================================
+{
+    static const std::size_t NUM_QUERIES = 1 << 20;
+    static const std::size_t SIZES[] = { 8, 64, 512, 4096, 32768, 65536 };
+
+    std::srand(1);
+    std::vector<double> queries(NUM_QUERIES);
+
+    double sum = 0; // keeps look-ups from being optimised away
+    std::printf("%8s %12s %12s %12s %12s  (ns/lookup)\n", "size", "pairs", "binary", "uniform", "eytzinger");
+    for( std::size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); ++s )
+    {
+        const std::size_t n = SIZES[s];
+        std::vector<double> x(n);
+        std::vector<double> y(n);
+        for( std::size_t i = 0; i < n; ++i )
+        {
+            x[i] = static_cast<double>(i);
+            y[i] = static_cast<double>(std::rand()) / RAND_MAX;
+        }
+        for( std::size_t i = 0; i < NUM_QUERIES; ++i )
+        {
+            queries[i] = static_cast<double>(n - 1) * std::rand() / RAND_MAX;
+        }
+
+        // the same table, with one point nudged so that it's searched for intervals
+        LookupTable1D<double, double> uniform(0, 1, y);
+        LookupTable1D<double, double> binary(x[0], y[0], x[1] + 1e-3, y[1]);
+        for( std::size_t i = 2; i < n; ++i )
+        {
+            binary.insertDataPoint(x[i], y[i]);
+        }
+
+        const double pairNs = timeLookups( PairTable(x, y), queries, sum );
+        const double binaryNs = timeLookups( binary, queries, sum );
+        const double uniformNs = timeLookups( uniform, queries, sum );
+        const double eytzingerNs = timeLookups( EytzingerTable(x, y), queries, sum );
+        std::printf("%8zu %12.2f %12.2f %12.2f %12.2f\n", n, pairNs, binaryNs, uniformNs, eytzingerNs);
+    }
+
+    std::printf("(checksum %g)\n", sum);
+    return 0;
+}
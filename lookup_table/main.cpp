@@ -8,12 +8,21 @@
 #include <iostream>
 
 extern int LookupTable1DTest(int argc, char** argv);
+#if __cplusplus >= 202002L
+extern int LookupTable1DBatchTest(int argc, char** argv);
+#endif
 
 //==============================================================================
 int main(int argc, char** argv)
 //==============================================================================
 {
     LookupTable1DTest(argc, argv);
+#if __cplusplus >= 202002L
+    if( LookupTable1DBatchTest(argc, argv) != 0 )
+    {
+        return 1;
+    }
+#endif
     return 0;
 }
 
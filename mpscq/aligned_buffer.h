@@ -0,0 +1,83 @@
+#ifndef ALIGNED_BUFFER_H
+#define ALIGNED_BUFFER_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <sys/mman.h>
+
+/// Size of a cache line. Data written by different threads should be at least this far apart.
+constexpr size_t cache_line_size = 64;
+
+/// Size of a (transparent) huge page on x86-64 and aarch64 linux
+constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+/// Uninitialised block of memory aligned to a cache line.
+/// Blocks of at least huge_page_size are aligned to a huge page boundary and advised to the kernel
+/// as candidates for transparent huge pages, which reduces TLB misses when the block is walked
+/// repeatedly (as ring buffers do).
+class aligned_buffer
+{
+public:
+  aligned_buffer() = default;
+  explicit aligned_buffer(size_t bytes, size_t alignment = cache_line_size);
+  ~aligned_buffer();
+  aligned_buffer(aligned_buffer &&other) noexcept;
+  aligned_buffer &operator=(aligned_buffer &&other) noexcept;
+  aligned_buffer(const aligned_buffer &) = delete;
+  aligned_buffer &operator=(const aligned_buffer &) = delete;
+
+  void *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  void *data_{nullptr};
+  size_t size_{0};
+};
+
+inline aligned_buffer::aligned_buffer(size_t bytes, size_t alignment)
+{
+  if (alignment < cache_line_size) {
+    alignment = cache_line_size;
+  }
+  if (bytes >= huge_page_size) {
+    alignment = huge_page_size;
+  }
+
+  // aligned_alloc requires size to be a multiple of alignment
+  size_ = (bytes + alignment - 1) / alignment * alignment;
+  data_ = std::aligned_alloc(alignment, size_);
+  if (data_ == nullptr) {
+    throw std::bad_alloc();
+  }
+
+#ifdef MADV_HUGEPAGE
+  if (alignment == huge_page_size) {
+    // advisory only; the buffer works the same with regular pages
+    (void)madvise(data_, size_, MADV_HUGEPAGE);
+  }
+#endif
+}
+
+inline aligned_buffer::~aligned_buffer()
+{
+  std::free(data_);
+}
+
+inline aligned_buffer::aligned_buffer(aligned_buffer &&other) noexcept
+  : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+{
+}
+
+inline aligned_buffer &aligned_buffer::operator=(aligned_buffer &&other) noexcept
+{
+  if (this != &other) {
+    std::free(data_);
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+#endif // ALIGNED_BUFFER_H
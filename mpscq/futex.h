@@ -0,0 +1,60 @@
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <climits>
+#include <ctime>
+#include <stdexcept>
+#include <system_error>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/// Block while word == expected, for at most timeout.
+/// \return true if woken up or word had already changed, false on timeout or interruption
+inline bool futexWait(const std::atomic<uint32_t> &word, uint32_t expected,
+                      std::chrono::nanoseconds timeout)
+{
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+  if (timeout.count() <= 0) {
+    return false;
+  }
+  const auto sec = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  const auto ts = timespec{sec.count(), (timeout - sec).count()};
+  const auto result = syscall(SYS_futex, &word, FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0);
+  if (result == -1) {
+    switch (errno) {
+    case EAGAIN:
+      return true; // value already changed
+    case ETIMEDOUT:
+    case EINTR:
+      return false;
+    default:
+      throw std::system_error(errno, std::system_category(), "futex_wait");
+    }
+  }
+  return true;
+}
+
+/// Wake up to num threads blocked on word
+inline void futexWake(const std::atomic<uint32_t> &word, int num = INT_MAX)
+{
+  if (syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, num, nullptr, nullptr, 0) == -1) {
+    throw std::system_error(errno, std::system_category(), "futex_wake");
+  }
+}
+
+/// Hint to the CPU that we are in a spin-wait loop
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+#endif // FUTEX_H
@@ -0,0 +1,104 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cinttypes>
+#include <cstddef>
+
+/// Log-linear histogram of latencies in nanoseconds, in the spirit of HdrHistogram.
+/// Each power of two is split into sub_buckets linear buckets, so values are recorded with a
+/// relative error of at most 1/sub_buckets, from 1 ns up to 2^64 ns, in fixed memory.
+/// Recording is lock-free and must be done from one thread. Snapshots can be taken from any thread.
+class latency_histogram
+{
+public:
+  static constexpr unsigned sub_bucket_bits = 4;
+  static constexpr size_t sub_buckets = size_t{1} << sub_bucket_bits;
+  static constexpr size_t num_buckets = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+  /// Copy of the histogram at a point in time
+  struct snapshot
+  {
+    std::array<uint64_t, num_buckets> counts{};
+    uint64_t total{0};
+    uint64_t max{0};
+
+    /// \param p Percentile in range [0, 100]
+    /// \return The highest value in the bucket that contains the p-th percentile (0 if empty)
+    uint64_t percentile(double p) const;
+  };
+
+  /// Record a value. Not safe to call from multiple threads.
+  void record(uint64_t value);
+
+  snapshot read() const;
+
+  static size_t bucketIndex(uint64_t value);
+  static uint64_t bucketHighestValue(size_t index);
+
+private:
+  std::array<std::atomic<uint64_t>, num_buckets> counts_{};
+  std::atomic<uint64_t> max_{0};
+};
+
+inline size_t latency_histogram::bucketIndex(uint64_t value)
+{
+  if (value < sub_buckets) {
+    return value;
+  }
+  // top sub_bucket_bits + 1 significant bits of the value select the bucket
+  const auto shift = static_cast<unsigned>(std::bit_width(value)) - sub_bucket_bits - 1;
+  return ((shift + 1) * sub_buckets) + ((value >> shift) - sub_buckets);
+}
+
+inline uint64_t latency_histogram::bucketHighestValue(size_t index)
+{
+  if (index < sub_buckets) {
+    return index;
+  }
+  const auto shift = (index / sub_buckets) - 1;
+  const auto lowest = (sub_buckets + (index % sub_buckets)) << shift;
+  return lowest + ((uint64_t{1} << shift) - 1);
+}
+
+inline void latency_histogram::record(uint64_t value)
+{
+  // single writer: plain load/store instead of read-modify-write
+  auto &bucket = counts_[bucketIndex(value)];
+  bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  if (value > max_.load(std::memory_order_relaxed)) {
+    max_.store(value, std::memory_order_relaxed);
+  }
+}
+
+inline latency_histogram::snapshot latency_histogram::read() const
+{
+  snapshot snap;
+  for (size_t i = 0; i < num_buckets; ++i) {
+    snap.counts[i] = counts_[i].load(std::memory_order_relaxed);
+    snap.total += snap.counts[i];
+  }
+  snap.max = max_.load(std::memory_order_relaxed);
+  return snap;
+}
+
+inline uint64_t latency_histogram::snapshot::percentile(double p) const
+{
+  if (total == 0) {
+    return 0;
+  }
+  const auto rank = static_cast<uint64_t>((p / 100.) * static_cast<double>(total - 1)) + 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < num_buckets; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return std::min(bucketHighestValue(i), max);
+    }
+  }
+  return max;
+}
+
+#endif // LATENCY_HISTOGRAM_H
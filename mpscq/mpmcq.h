@@ -0,0 +1,110 @@
+#ifndef MPMCQ_H
+#define MPMCQ_H
+
+#include <atomic>
+#include <cassert>
+#include <cinttypes>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+/// bounded multi-producer, multi-consumer queue.
+/// Each slot carries a sequence number that tells producers and consumers which 'lap' of the ring
+/// the slot is ready for, which replaces the is_readable_ flags of mpscq and lets any number of
+/// threads pop concurrently.
+/// Inspired from http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+template <typename T, size_t capacity_>
+class mpmcq
+{
+public:
+  mpmcq();
+  bool tryPush(T &&obj);
+  std::optional<T> tryPop();
+  size_t count() const;
+
+private:
+  struct Slot
+  {
+    std::atomic<size_t> sequence{0};
+    T value{};
+  };
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  std::vector<Slot> slots_;
+};
+
+template <typename T, size_t capacity_>
+mpmcq<T, capacity_>::mpmcq() : slots_(capacity_)
+{
+  assert(capacity_ >= 1);
+  // slot i is ready to be written by the producer that claims position i
+  for (size_t i = 0; i < capacity_; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+/// Attempt to enqueue without blocking. This is safe to call from multiple threads.
+/// \return true on success and false if queue is full.
+template <typename T, size_t capacity_>
+bool mpmcq<T, capacity_>::tryPush(T &&obj)
+{
+  auto head = head_.load(std::memory_order_relaxed);
+  while (true) {
+    auto &slot = slots_[head % capacity_];
+    const auto seq = slot.sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(head);
+    if (diff == 0) {
+      // slot is free for this lap; try to claim the position
+      if (head_.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+        slot.value = std::move(obj);
+        slot.sequence.store(head + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // slot still holds an item from the previous lap: queue is full
+      return false;
+    } else {
+      // another producer got here first
+      head = head_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+/// Attempt to dequeue without blocking. This is safe to call from multiple threads.
+/// \return A valid item from queue if the operation won't block, else nothing
+template <typename T, size_t capacity_>
+std::optional<T> mpmcq<T, capacity_>::tryPop()
+{
+  auto tail = tail_.load(std::memory_order_relaxed);
+  while (true) {
+    auto &slot = slots_[tail % capacity_];
+    const auto seq = slot.sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(tail + 1);
+    if (diff == 0) {
+      // slot was published for this lap; try to claim it
+      if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+        auto ret = std::move(slot.value);
+        // hand the slot over to the producer of the next lap
+        slot.sequence.store(tail + capacity_, std::memory_order_release);
+        return ret;
+      }
+    } else if (diff < 0) {
+      // nothing published yet (queue empty, or producer still writing)
+      return {};
+    } else {
+      // another consumer got here first
+      tail = tail_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+/// \return The (approximate) number of items in queue
+template <typename T, size_t capacity_>
+size_t mpmcq<T, capacity_>::count() const
+{
+  const auto tail = tail_.load(std::memory_order_relaxed);
+  const auto head = head_.load(std::memory_order_relaxed);
+  return (head > tail) ? (head - tail) : 0;
+}
+
+#endif // MPMCQ_H
@@ -0,0 +1,89 @@
+#include "mpmcq.h"
+#include "mpscq.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+constexpr size_t Q_LEN = 1024;
+constexpr size_t NUM_PRODUCERS = 2;
+constexpr size_t ITEMS_PER_RUN = 1 << 18;
+
+/// Status quo: single-consumer queue with a mutex serialising the consumers
+template <typename T, size_t capacity_>
+class LockedConsumerQueue
+{
+public:
+  bool tryPush(T &&obj) { return queue_.tryPush(std::move(obj)); }
+  std::optional<T> tryPop()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.tryPop();
+  }
+
+private:
+  mpscq<T, capacity_> queue_;
+  std::mutex mutex_;
+};
+
+/// Move ITEMS_PER_RUN items from NUM_PRODUCERS producers to state.range(0) consumers and time it
+template <typename Queue>
+void bmConsumerScaling(benchmark::State &state)
+{
+  const auto num_consumers = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    Queue queue;
+    std::atomic<size_t> consumed{0};
+    std::vector<std::thread> threads;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t p = 0; p < NUM_PRODUCERS; ++p) {
+      threads.emplace_back([&queue] {
+        for (size_t i = 0; i < ITEMS_PER_RUN / NUM_PRODUCERS; ++i) {
+          while (!queue.tryPush(uint64_t{i})) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    for (size_t c = 0; c < num_consumers; ++c) {
+      threads.emplace_back([&queue, &consumed] {
+        while (consumed.load(std::memory_order_relaxed) < ITEMS_PER_RUN) {
+          auto item = queue.tryPop();
+          if (item.has_value()) {
+            benchmark::DoNotOptimize(item);
+            consumed.fetch_add(1, std::memory_order_relaxed);
+          } else {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    state.SetIterationTime(elapsed.count());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * ITEMS_PER_RUN));
+}
+
+BENCHMARK_TEMPLATE(bmConsumerScaling, mpmcq<uint64_t, Q_LEN>)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(bmConsumerScaling, LockedConsumerQueue<uint64_t, Q_LEN>)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
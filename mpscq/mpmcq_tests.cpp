@@ -0,0 +1,139 @@
+#define CATCH_CONFIG_MAIN
+#include "mpmcq.h"
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Empty queue has nothing to pop", "[mpmcq]")
+{
+  mpmcq<int, 4> queue;
+  REQUIRE_FALSE(queue.tryPop().has_value());
+  REQUIRE(queue.count() == 0);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Items are popped in the order they were pushed", "[mpmcq]")
+{
+  mpmcq<int, 8> queue;
+  for (int i = 0; i < 8; ++i) {
+    REQUIRE(queue.tryPush(int{i}));
+  }
+  REQUIRE(queue.count() == 8);
+  for (int i = 0; i < 8; ++i) {
+    REQUIRE(queue.tryPop() == i);
+  }
+  REQUIRE_FALSE(queue.tryPop().has_value());
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Push fails when the queue is full, and succeeds again after a pop", "[mpmcq]")
+{
+  constexpr int N = 3; // not a power of two
+  mpmcq<int, N> queue;
+
+  // several laps of the ring
+  int next_push = 0;
+  int next_pop = 0;
+  for (int lap = 0; lap < 5; ++lap) {
+    while (queue.tryPush(int{next_push})) {
+      ++next_push;
+    }
+    REQUIRE(queue.count() == N);
+    REQUIRE(queue.tryPop() == next_pop++);
+    REQUIRE(queue.tryPush(int{next_push++}));
+    REQUIRE_FALSE(queue.tryPush(-1));
+    while (auto item = queue.tryPop()) {
+      REQUIRE(item.value() == next_pop++);
+    }
+    REQUIRE(queue.count() == 0);
+  }
+  REQUIRE(next_pop == next_push);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Items that aren't trivially copyable are moved through", "[mpmcq]")
+{
+  mpmcq<std::string, 2> queue;
+  const auto long_string = std::string(100, 'x');
+  REQUIRE(queue.tryPush(std::string(long_string)));
+  REQUIRE(queue.tryPop() == long_string);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Producer and consumer threads transfer every item exactly once", "[mpmcq]")
+{
+  constexpr uint64_t NUM_PRODUCERS = 4;
+  constexpr uint64_t NUM_CONSUMERS = 4;
+  constexpr uint64_t ITEMS_PER_PRODUCER = 50'000;
+  mpmcq<uint64_t, 64> queue;
+
+  // items carry their producer in the high bits and a sequence number in the low bits
+  std::vector<std::thread> producers;
+  for (uint64_t p = 0; p < NUM_PRODUCERS; ++p) {
+    producers.emplace_back([&queue, p] {
+      for (uint64_t i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+        while (!queue.tryPush((p << 32U) | i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::atomic<uint64_t> num_popped{0};
+  std::vector<std::vector<uint64_t>> received(NUM_CONSUMERS);
+  std::vector<std::thread> consumers;
+  for (uint64_t c = 0; c < NUM_CONSUMERS; ++c) {
+    consumers.emplace_back([&queue, &num_popped, &items = received[c]] {
+      while (num_popped.load() < NUM_PRODUCERS * ITEMS_PER_PRODUCER) {
+        if (auto item = queue.tryPop()) {
+          items.push_back(item.value());
+          num_popped.fetch_add(1);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &thread : producers) {
+    thread.join();
+  }
+  for (auto &thread : consumers) {
+    thread.join();
+  }
+
+  // each consumer sees the items of any one producer in the order they were pushed
+  std::vector<uint64_t> all;
+  for (const auto &items : received) {
+    std::vector<uint64_t> last(NUM_PRODUCERS, 0);
+    std::vector<bool> seen(NUM_PRODUCERS, false);
+    bool in_order = true;
+    for (const auto item : items) {
+      const auto p = item >> 32U;
+      const auto i = item & 0xffffffffU;
+      in_order = in_order && (!seen[p] || i > last[p]);
+      seen[p] = true;
+      last[p] = i;
+    }
+    REQUIRE(in_order);
+    all.insert(all.end(), items.begin(), items.end());
+  }
+
+  std::vector<uint64_t> expected;
+  for (uint64_t p = 0; p < NUM_PRODUCERS; ++p) {
+    for (uint64_t i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+      expected.push_back((p << 32U) | i);
+    }
+  }
+  std::sort(all.begin(), all.end());
+  REQUIRE(all == expected);
+  REQUIRE_FALSE(queue.tryPop().has_value());
+}
+
+} // namespace
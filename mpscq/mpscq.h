@@ -1,91 +1,582 @@
 #ifndef MPSCQ_H
 #define MPSCQ_H
 
+#include "aligned_buffer.h"
+#include "futex.h"
+#ifdef MPSCQ_STATS
+#include "latency_histogram.h"
+#endif
+#include <algorithm>
 #include <atomic>
+#include <bit>
 #include <cassert>
+#include <chrono>
 #include <cinttypes>
 #include <cstddef>
+#include <memory>
+#include <new>
 #include <optional>
-#include <vector>
+#include <span>
+
+/// Memory layout of the queue state shared between producers and consumer
+enum class mpscq_layout
+{
+  compact, ///< Counters next to each other, readable flags in a dense array. Smallest footprint.
+  padded   ///< Producer and consumer counters on separate cache lines, one slot per cache line
+};
+
+/// Capacity template argument for a queue sized at construction
+constexpr size_t mpscq_dynamic_capacity = 0;
+
+#ifdef MPSCQ_STATS
+/// Instrumentation counters of a queue, see mpscq::stats()
+struct mpscq_stats
+{
+  latency_histogram::snapshot latency; ///< time from publish to release of each item, in ns
+  uint64_t rejected{0};                ///< number of items not enqueued because the queue was full
+  size_t high_water_mark{0};           ///< highest number of items in queue at once
+};
+#endif
+
+namespace mpscq_detail
+{
+
+#ifdef MPSCQ_STATS
+inline uint64_t nowNs()
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+}
+#endif
+
+/// Slot storage for mpscq. Holds a readable flag and uninitialised storage for one value per slot.
+/// Values are constructed in place by producers and destroyed by the consumer.
+template <typename T, mpscq_layout layout_>
+class slots;
+
+/// Flags and values in two dense arrays (in one block of memory).
+/// Adjacent slots share cache lines, so a producer writing slot i+1 contends with the consumer
+/// reading slot i.
+template <typename T>
+class slots<T, mpscq_layout::compact>
+{
+public:
+  explicit slots(size_t capacity);
+  slots(const slots &) = delete;
+  slots &operator=(const slots &) = delete;
+
+  std::atomic<bool> &readable(size_t index) { return flags_[index]; }
+  void *storage(size_t index) { return values_ + index * sizeof(T); }
+  T *value(size_t index) { return std::launder(static_cast<T *>(storage(index))); }
+#ifdef MPSCQ_STATS
+  uint64_t &publishTime(size_t index) { return publish_times_[index]; }
+#endif
+
+private:
+  static size_t valuesOffset(size_t capacity);
+  aligned_buffer buffer_;
+  std::atomic<bool> *flags_{nullptr};
+  std::byte *values_{nullptr};
+#ifdef MPSCQ_STATS
+  std::unique_ptr<uint64_t[]> publish_times_;
+#endif
+};
+
+/// Flag and value interleaved, each slot starting on its own cache line
+template <typename T>
+class slots<T, mpscq_layout::padded>
+{
+public:
+  explicit slots(size_t capacity);
+  slots(const slots &) = delete;
+  slots &operator=(const slots &) = delete;
+
+  std::atomic<bool> &readable(size_t index) { return slots_[index].is_readable; }
+  void *storage(size_t index) { return slots_[index].storage; }
+  T *value(size_t index) { return std::launder(static_cast<T *>(storage(index))); }
+#ifdef MPSCQ_STATS
+  uint64_t &publishTime(size_t index) { return slots_[index].publish_time; }
+#endif
+
+private:
+  struct alignas(std::max(cache_line_size, alignof(T))) Slot
+  {
+    std::atomic<bool> is_readable{false};
+#ifdef MPSCQ_STATS
+    uint64_t publish_time{0};
+#endif
+    alignas(T) std::byte storage[sizeof(T)];
+  };
+  aligned_buffer buffer_;
+  Slot *slots_{nullptr};
+};
+
+template <typename T>
+size_t slots<T, mpscq_layout::compact>::valuesOffset(size_t capacity)
+{
+  const auto flags_size = capacity * sizeof(std::atomic<bool>);
+  return (flags_size + alignof(T) - 1) / alignof(T) * alignof(T);
+}
+
+template <typename T>
+slots<T, mpscq_layout::compact>::slots(size_t capacity)
+  : buffer_(valuesOffset(capacity) + capacity * sizeof(T), alignof(T))
+#ifdef MPSCQ_STATS
+  , publish_times_(std::make_unique<uint64_t[]>(capacity))
+#endif
+{
+  auto *base = static_cast<std::byte *>(buffer_.data());
+  flags_ = reinterpret_cast<std::atomic<bool> *>(base);
+  values_ = base + valuesOffset(capacity);
+  for (size_t i = 0; i < capacity; ++i) {
+    new (&flags_[i]) std::atomic<bool>(false);
+  }
+}
+
+template <typename T>
+slots<T, mpscq_layout::padded>::slots(size_t capacity)
+  : buffer_(capacity * sizeof(Slot), alignof(Slot))
+{
+  slots_ = static_cast<Slot *>(buffer_.data());
+  for (size_t i = 0; i < capacity; ++i) {
+    new (&slots_[i]) Slot();
+  }
+}
+
+} // namespace mpscq_detail
 
 /// multi-producer, single consumer queue.
+/// Capacity is either fixed at compile time, or set at construction when capacity_ is
+/// mpscq_dynamic_capacity. Slot indices are computed with a mask instead of a modulo for
+/// power-of-two compile-time capacities, and always for runtime capacities, whose slot array is
+/// rounded up to a power of two (the queue still holds at most the requested number of items).
 /// Inspired from https://github.com/dbittman/waitfree-mpsc-queue
-template <typename T, size_t capacity_>
+template <typename T, size_t capacity_, mpscq_layout layout_ = mpscq_layout::compact>
 class mpscq
 {
 public:
-  mpscq();
+  /// A slot claimed by a producer for in-place construction. See tryClaim()
+  struct Claim
+  {
+    void *storage{nullptr}; ///< uninitialised, suitably aligned storage for one T
+    size_t index{0};
+    explicit operator bool() const { return storage != nullptr; }
+  };
+
+  mpscq()
+    requires(capacity_ != mpscq_dynamic_capacity);
+  explicit mpscq(size_t capacity)
+    requires(capacity_ == mpscq_dynamic_capacity);
+  ~mpscq();
+  mpscq(const mpscq &) = delete;
+  mpscq &operator=(const mpscq &) = delete;
+
   bool tryPush(T &&obj);
+  template <typename... Args>
+  bool tryEmplace(Args &&...args) noexcept;
+  Claim tryClaim();
+  void commit(const Claim &claim);
+  size_t tryPushN(std::span<T> objs);
+
+  T *front();
+  template <typename Rep, typename Period>
+  T *front(const std::chrono::duration<Rep, Period> &timeout);
+  void release();
   std::optional<T> tryPop();
+  template <typename OutputIt>
+  size_t tryPopN(OutputIt out, size_t max);
+  template <typename Rep, typename Period>
+  std::optional<T> pop(const std::chrono::duration<Rep, Period> &timeout);
   size_t count() const;
+  size_t capacity() const;
+#ifdef MPSCQ_STATS
+  mpscq_stats stats() const;
+#endif
 
 private:
-  std::atomic<size_t> count_{0};
+  static constexpr uint32_t min_spin_ = 16;
+  static constexpr uint32_t max_spin_ = 4096;
+  void wakeConsumer();
+  size_t index(size_t seq) const;
+#ifdef MPSCQ_STATS
+  void raiseHighWaterMark(size_t count);
+#endif
+
+  static constexpr size_t counter_alignment_ =
+      (layout_ == mpscq_layout::padded) ? cache_line_size : alignof(std::atomic<size_t>);
+
+  // read-only after construction
+  size_t runtime_capacity_{capacity_}; ///< only used with mpscq_dynamic_capacity
+  size_t mask_{0};                     ///< only used with mpscq_dynamic_capacity
+  mpscq_detail::slots<T, layout_> slots_;
+
+  // modified by producers (count_ is also decremented by the consumer)
+  alignas(counter_alignment_) std::atomic<size_t> count_{0};
   std::atomic<size_t> head_{0};
-  size_t tail_{0};
-  std::vector<std::atomic<bool>> is_readable_;
-  std::vector<T> buffer_;
+
+  // modified by consumer only
+  alignas(counter_alignment_) size_t tail_{0}; ///< sequence number of the next item to pop
+  uint32_t spin_limit_{256};
+
+  // futex word, set by the consumer when it parks in front(timeout). Read by producers on every push.
+  alignas(counter_alignment_) std::atomic<uint32_t> parked_{0};
+
+#ifdef MPSCQ_STATS
+  // modified by producers
+  alignas(counter_alignment_) std::atomic<uint64_t> rejected_{0};
+  std::atomic<size_t> high_water_mark_{0};
+
+  // modified by consumer only
+  alignas(counter_alignment_) latency_histogram latency_;
+#endif
 };
 
-template <typename T, size_t capacity_>
-mpscq<T, capacity_>::mpscq() : is_readable_(capacity_), buffer_(capacity_)
+template <typename T, size_t capacity_, mpscq_layout layout_>
+mpscq<T, capacity_, layout_>::mpscq()
+  requires(capacity_ != mpscq_dynamic_capacity)
+  : slots_(capacity_)
 {
-  assert(capacity_ >= 1);
-  for (auto &i : is_readable_) {
-    i = false;
+}
+
+/// \param capacity Maximum number of items in the queue. Storage is allocated for
+/// std::bit_ceil(capacity) items.
+template <typename T, size_t capacity_, mpscq_layout layout_>
+mpscq<T, capacity_, layout_>::mpscq(size_t capacity)
+  requires(capacity_ == mpscq_dynamic_capacity)
+  : runtime_capacity_(capacity), mask_(std::bit_ceil(capacity) - 1), slots_(mask_ + 1)
+{
+  assert(capacity >= 1);
+}
+
+template <typename T, size_t capacity_, mpscq_layout layout_>
+mpscq<T, capacity_, layout_>::~mpscq()
+{
+  // destroy items that were never popped
+  while (front() != nullptr) {
+    release();
   }
 }
 
 /// Attempt to enqueue without blocking. This is safe to call from multiple threads.
 /// \return true on success and false if queue is full.
-template <typename T, size_t capacity_>
-bool mpscq<T, capacity_>::tryPush(T &&obj)
+template <typename T, size_t capacity_, mpscq_layout layout_>
+bool mpscq<T, capacity_, layout_>::tryPush(T &&obj)
+{
+  return tryEmplace(std::move(obj));
+}
+
+/// Attempt to construct an item in place in the queue without blocking. This is safe to call from
+/// multiple threads.
+/// \note: The constructor of T must not throw. If it does, std::terminate is called, because the
+/// claimed slot can no longer be handed back.
+/// \return true on success and false if queue is full.
+template <typename T, size_t capacity_, mpscq_layout layout_>
+template <typename... Args>
+bool mpscq<T, capacity_, layout_>::tryEmplace(Args &&...args) noexcept
+{
+  const auto claim = tryClaim();
+  if (!claim) {
+    return false;
+  }
+  new (claim.storage) T(std::forward<Args>(args)...);
+  commit(claim);
+  return true;
+}
+
+/// Attempt to claim a slot without blocking, for the caller to construct an item in place. This is
+/// safe to call from multiple threads.
+/// A successful claim must be followed by constructing a T at claim.storage and then by commit().
+/// The consumer cannot progress past the slot until it is committed.
+/// \return A valid claim on success, or an empty claim if the queue is full
+template <typename T, size_t capacity_, mpscq_layout layout_>
+typename mpscq<T, capacity_, layout_>::Claim mpscq<T, capacity_, layout_>::tryClaim()
 {
   auto count = count_.fetch_add(1, std::memory_order_acquire);
-  if (count >= capacity_) {
+  if (count >= capacity()) {
     // back off, queue is full
     count_.fetch_sub(1, std::memory_order_release);
-    return false;
+#ifdef MPSCQ_STATS
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+#endif
+    return {};
   }
+#ifdef MPSCQ_STATS
+  raiseHighWaterMark(count + 1);
+#endif
 
   // increment the head, which gives us 'exclusive' access to that element until
   // is_reabable_ flag is set
-  const auto head = head_.fetch_add(1, std::memory_order_acquire) % capacity_;
-  buffer_[head] = std::move(obj);
-  assert(is_readable_[head] == false);
-  is_readable_[head].store(true, std::memory_order_release);
-  return true;
+  const auto head = index(head_.fetch_add(1, std::memory_order_acquire));
+  assert(slots_.readable(head) == false);
+  return Claim{slots_.storage(head), head};
+}
+
+/// Publish a slot obtained with tryClaim() to the consumer. The item must have been constructed.
+template <typename T, size_t capacity_, mpscq_layout layout_>
+void mpscq<T, capacity_, layout_>::commit(const Claim &claim)
+{
+  assert(claim);
+#ifdef MPSCQ_STATS
+  slots_.publishTime(claim.index) = mpscq_detail::nowNs();
+#endif
+  slots_.readable(claim.index).store(true, std::memory_order_release);
+  wakeConsumer();
+}
+
+/// Attempt to enqueue a batch without blocking. This is safe to call from multiple threads.
+/// A contiguous run of slots is reserved with one update of the count and one of the head, instead
+/// of two per element as with tryPush. Elements are moved from the front of objs.
+/// \return Number of elements enqueued. Less than objs.size() if the queue filled up.
+template <typename T, size_t capacity_, mpscq_layout layout_>
+size_t mpscq<T, capacity_, layout_>::tryPushN(std::span<T> objs)
+{
+  // reserve as many elements as will fit
+  auto count = count_.load(std::memory_order_relaxed);
+  size_t num = 0;
+  do {
+    num = (count < capacity()) ? std::min(objs.size(), capacity() - count) : 0;
+  } while (num > 0 && !count_.compare_exchange_weak(count, count + num, std::memory_order_acquire,
+                                                    std::memory_order_relaxed));
+#ifdef MPSCQ_STATS
+  if (num < objs.size()) {
+    rejected_.fetch_add(objs.size() - num, std::memory_order_relaxed);
+  }
+  if (num > 0) {
+    raiseHighWaterMark(count + num);
+  }
+  const auto publish_time = mpscq_detail::nowNs();
+#endif
+  if (num == 0) {
+    return 0;
+  }
+
+  // claim a contiguous run of slots starting at head
+  const auto head = head_.fetch_add(num, std::memory_order_acquire);
+  for (size_t i = 0; i < num; ++i) {
+    const auto slot = index(head + i);
+    new (slots_.storage(slot)) T(std::move(objs[i]));
+    assert(slots_.readable(slot) == false);
+#ifdef MPSCQ_STATS
+    slots_.publishTime(slot) = publish_time;
+#endif
+    slots_.readable(slot).store(true, std::memory_order_release);
+  }
+  wakeConsumer();
+  return num;
+}
+
+/// Access the oldest item in place, without dequeuing it.
+/// \note: This is not safe to call from multiple threads.
+/// \return Pointer to the oldest item, valid until release() is called, or nullptr if no item is
+/// readable yet
+template <typename T, size_t capacity_, mpscq_layout layout_>
+T *mpscq<T, capacity_, layout_>::front()
+{
+  const auto tail = index(tail_);
+  if (!slots_.readable(tail).load(std::memory_order_acquire)) {
+    // A thread could still be writing to this location
+    return nullptr;
+  }
+  return slots_.value(tail);
+}
+
+/// Destroy the item returned by front() and hand its slot back to producers.
+/// \note: This is not safe to call from multiple threads. Only call after front() returned an item.
+template <typename T, size_t capacity_, mpscq_layout layout_>
+void mpscq<T, capacity_, layout_>::release()
+{
+  const auto tail = index(tail_++);
+  assert(slots_.readable(tail));
+#ifdef MPSCQ_STATS
+  latency_.record(mpscq_detail::nowNs() - slots_.publishTime(tail));
+#endif
+  slots_.value(tail)->~T();
+  slots_.readable(tail).store(false, std::memory_order_release);
+
+  [[maybe_unused]] const auto count = count_.fetch_sub(1, std::memory_order_release);
+  assert(count > 0);
 }
 
 /// Attempt to dequeue without blocking
 /// \note: This is not safe to call from multiple threads.
 /// \return A valid item from queue if the operation won't block, else nothing
-template <typename T, size_t capacity_>
-std::optional<T> mpscq<T, capacity_>::tryPop()
+template <typename T, size_t capacity_, mpscq_layout layout_>
+std::optional<T> mpscq<T, capacity_, layout_>::tryPop()
 {
-  if (!is_readable_[tail_].load(std::memory_order_acquire)) {
-    // A thread could still be writing to this location
+  auto *item = front();
+  if (item == nullptr) {
     return {};
   }
+  std::optional<T> ret(std::move(*item));
+  release();
+  return ret;
+}
 
-  assert(is_readable_[tail_]);
-  auto ret = std::move(buffer_[tail_]);
-  is_readable_[tail_].store(false, std::memory_order_release);
+/// Dequeue everything that is readable, up to max elements, without blocking. The count is updated
+/// once for the whole batch.
+/// \note: This is not safe to call from multiple threads.
+/// \param out Output iterator the dequeued elements are moved to
+/// \param max Maximum number of elements to dequeue
+/// \return Number of elements dequeued
+template <typename T, size_t capacity_, mpscq_layout layout_>
+template <typename OutputIt>
+size_t mpscq<T, capacity_, layout_>::tryPopN(OutputIt out, size_t max)
+{
+  size_t num = 0;
+  while (num < max) {
+    const auto tail = index(tail_);
+    if (!slots_.readable(tail).load(std::memory_order_acquire)) {
+      break;
+    }
+#ifdef MPSCQ_STATS
+    latency_.record(mpscq_detail::nowNs() - slots_.publishTime(tail));
+#endif
+    auto *item = slots_.value(tail);
+    *out = std::move(*item);
+    ++out;
+    item->~T();
+    slots_.readable(tail).store(false, std::memory_order_release);
+    ++tail_;
+    ++num;
+  }
 
-  if (++tail_ >= capacity_) {
-    tail_ = 0;
+  if (num > 0) {
+    [[maybe_unused]] const auto count = count_.fetch_sub(num, std::memory_order_release);
+    assert(count >= num);
   }
+  return num;
+}
 
-  const auto count = count_.fetch_sub(1, std::memory_order_release);
-  assert(count > 0);
+/// Access the oldest item in place, waiting up to timeout for an item to arrive.
+/// Spins first, for a number of iterations that adapts to how often spinning succeeds, then parks
+/// the thread on a futex until a producer publishes an item.
+/// \note: This is not safe to call from multiple threads.
+/// \return Pointer to the oldest item, valid until release() is called, or nullptr if timed out
+template <typename T, size_t capacity_, mpscq_layout layout_>
+template <typename Rep, typename Period>
+T *mpscq<T, capacity_, layout_>::front(const std::chrono::duration<Rep, Period> &timeout)
+{
+  using clock = std::chrono::steady_clock;
+  const auto deadline = clock::now() + std::chrono::duration_cast<clock::duration>(timeout);
+  uint32_t spins = 0;
+  while (true) {
+    auto *item = front();
+    if (item != nullptr) {
+      if (spins > 0 && spins < spin_limit_) {
+        // spinning paid off, be more patient next time
+        spin_limit_ = std::min(spin_limit_ * 2, max_spin_);
+      }
+      return item;
+    }
+
+    if (spins < spin_limit_) {
+      ++spins;
+      cpuRelax();
+      continue;
+    }
+
+    const auto now = clock::now();
+    if (now >= deadline) {
+      return nullptr;
+    }
+
+    // spinning didn't pay off, be less patient next time
+    if (spins == spin_limit_) {
+      spin_limit_ = std::max(spin_limit_ / 2, min_spin_);
+      ++spins;
+    }
+
+    // announce that we are about to sleep, then check again so that a producer that published
+    // before seeing the announcement isn't missed (pairs with the fence in wakeConsumer)
+    parked_.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!slots_.readable(index(tail_)).load(std::memory_order_relaxed)) {
+      futexWait(parked_, 1, deadline - now);
+    }
+    parked_.store(0, std::memory_order_relaxed);
+  }
+}
+
+/// Dequeue, waiting up to timeout for an item to arrive. See front(timeout)
+/// \note: This is not safe to call from multiple threads.
+/// \return A valid item from queue, or nothing if timed out
+template <typename T, size_t capacity_, mpscq_layout layout_>
+template <typename Rep, typename Period>
+std::optional<T> mpscq<T, capacity_, layout_>::pop(const std::chrono::duration<Rep, Period> &timeout)
+{
+  auto *item = front(timeout);
+  if (item == nullptr) {
+    return {};
+  }
+  std::optional<T> ret(std::move(*item));
+  release();
   return ret;
 }
 
+/// Wake up the consumer if it is parked in front(timeout). No system call unless it is.
+template <typename T, size_t capacity_, mpscq_layout layout_>
+void mpscq<T, capacity_, layout_>::wakeConsumer()
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (parked_.load(std::memory_order_relaxed) != 0 &&
+      parked_.exchange(0, std::memory_order_relaxed) != 0) {
+    futexWake(parked_, 1);
+  }
+}
+
 /// \return The number of items in queue
-template <typename T, size_t capacity_>
-size_t mpscq<T, capacity_>::count() const
+template <typename T, size_t capacity_, mpscq_layout layout_>
+size_t mpscq<T, capacity_, layout_>::count() const
 {
   return count_.load(std::memory_order_relaxed);
 }
 
+/// \return The maximum number of items in queue
+template <typename T, size_t capacity_, mpscq_layout layout_>
+size_t mpscq<T, capacity_, layout_>::capacity() const
+{
+  if constexpr (capacity_ == mpscq_dynamic_capacity) {
+    return runtime_capacity_;
+  } else {
+    return capacity_;
+  }
+}
+
+#ifdef MPSCQ_STATS
+/// Read the instrumentation counters. Only available when compiled with MPSCQ_STATS defined.
+/// This is safe to call from any thread, concurrently with pushes and pops. Counters are read one
+/// at a time, so they may be slightly out of step with each other.
+/// \return Copy of the counters since construction
+template <typename T, size_t capacity_, mpscq_layout layout_>
+mpscq_stats mpscq<T, capacity_, layout_>::stats() const
+{
+  return mpscq_stats{latency_.read(), rejected_.load(std::memory_order_relaxed),
+                     high_water_mark_.load(std::memory_order_relaxed)};
+}
+
+/// Record the number of items in queue after a successful claim, if it is a new maximum
+template <typename T, size_t capacity_, mpscq_layout layout_>
+void mpscq<T, capacity_, layout_>::raiseHighWaterMark(size_t count)
+{
+  auto high_water_mark = high_water_mark_.load(std::memory_order_relaxed);
+  while (count > high_water_mark &&
+         !high_water_mark_.compare_exchange_weak(high_water_mark, count, std::memory_order_relaxed)) {
+  }
+}
+#endif
+
+/// \return Slot index for a head/tail sequence number
+template <typename T, size_t capacity_, mpscq_layout layout_>
+size_t mpscq<T, capacity_, layout_>::index(size_t seq) const
+{
+  if constexpr (capacity_ == mpscq_dynamic_capacity) {
+    return seq & mask_;
+  } else if constexpr (std::has_single_bit(capacity_)) {
+    return seq & (capacity_ - 1);
+  } else {
+    return seq % capacity_;
+  }
+}
+
 #endif // MPSCQ_H
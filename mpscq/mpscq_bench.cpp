@@ -0,0 +1,216 @@
+#include "mpscq.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <memory>
+#include <array>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+
+constexpr size_t Q_LEN = 1024;
+constexpr size_t ITEMS_PER_RUN = 1 << 18;
+
+/// Move ITEMS_PER_RUN items from state.range(0) producers to one consumer and time it
+template <typename Queue>
+void bmProducerContention(benchmark::State &state)
+{
+  const auto num_producers = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    auto queue = std::make_unique<Queue>();
+    std::vector<std::thread> producers;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t p = 0; p < num_producers; ++p) {
+      producers.emplace_back([&queue, num_producers] {
+        for (size_t i = 0; i < ITEMS_PER_RUN / num_producers; ++i) {
+          while (!queue->tryPush(uint64_t{i})) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    const auto num_items = (ITEMS_PER_RUN / num_producers) * num_producers;
+    size_t consumed = 0;
+    while (consumed < num_items) {
+      auto item = queue->tryPop();
+      if (item.has_value()) {
+        benchmark::DoNotOptimize(item);
+        ++consumed;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    for (auto &t : producers) {
+      t.join();
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    state.SetIterationTime(elapsed.count());
+    state.SetItemsProcessed(state.items_processed() + static_cast<int64_t>(num_items));
+#ifdef MPSCQ_STATS
+    // instrumentation of the last run
+    const auto stats = queue->stats();
+    state.counters["p50_ns"] = static_cast<double>(stats.latency.percentile(50));
+    state.counters["p99_ns"] = static_cast<double>(stats.latency.percentile(99));
+    state.counters["p999_ns"] = static_cast<double>(stats.latency.percentile(99.9));
+    state.counters["rejected"] = static_cast<double>(stats.rejected);
+    state.counters["high_water"] = static_cast<double>(stats.high_water_mark);
+#endif
+  }
+}
+
+BENCHMARK_TEMPLATE(bmProducerContention, mpscq<uint64_t, Q_LEN, mpscq_layout::compact>)
+    ->RangeMultiplier(2)
+    ->Range(2, 16)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(bmProducerContention, mpscq<uint64_t, Q_LEN, mpscq_layout::padded>)
+    ->RangeMultiplier(2)
+    ->Range(2, 16)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+/// Move ITEMS_PER_RUN items from 4 producers to one consumer in batches of state.range(0) items.
+/// A batch size of 1 uses tryPush/tryPop
+template <typename Queue>
+void bmBatchTransfer(benchmark::State &state)
+{
+  constexpr size_t NUM_PRODUCERS = 4;
+  constexpr size_t MAX_BATCH = 64;
+  const auto batch_size = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    auto queue = std::make_unique<Queue>();
+    std::vector<std::thread> producers;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t p = 0; p < NUM_PRODUCERS; ++p) {
+      producers.emplace_back([&queue, batch_size] {
+        std::array<uint64_t, MAX_BATCH> batch{};
+        size_t remaining = ITEMS_PER_RUN / NUM_PRODUCERS;
+        while (remaining > 0) {
+          size_t pushed = 0;
+          if (batch_size == 1) {
+            pushed = queue->tryPush(uint64_t{remaining}) ? 1 : 0;
+          } else {
+            const auto num = std::min(batch_size, remaining);
+            pushed = queue->tryPushN(std::span<uint64_t>(batch.data(), num));
+          }
+          remaining -= pushed;
+          if (pushed == 0) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    std::array<uint64_t, MAX_BATCH> batch{};
+    size_t consumed = 0;
+    while (consumed < ITEMS_PER_RUN) {
+      size_t popped = 0;
+      if (batch_size == 1) {
+        auto item = queue->tryPop();
+        popped = item.has_value() ? 1 : 0;
+        benchmark::DoNotOptimize(item);
+      } else {
+        popped = queue->tryPopN(batch.begin(), batch_size);
+        benchmark::DoNotOptimize(batch);
+      }
+      consumed += popped;
+      if (popped == 0) {
+        std::this_thread::yield();
+      }
+    }
+    for (auto &t : producers) {
+      t.join();
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    state.SetIterationTime(elapsed.count());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * ITEMS_PER_RUN));
+}
+
+BENCHMARK_TEMPLATE(bmBatchTransfer, mpscq<uint64_t, Q_LEN, mpscq_layout::padded>)
+    ->RangeMultiplier(8)
+    ->Range(1, 64)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+/// 512 byte payload, as in mpscq_example
+struct HeavyObject
+{
+  HeavyObject(uint32_t val = 0) { value[0] = val; }
+  uint32_t value[128];
+};
+
+/// Push and pop a HeavyObject by moving it in and out of the queue (two copies per message)
+void bmHeavyObjectMove(benchmark::State &state)
+{
+  auto queue = std::make_unique<mpscq<HeavyObject, Q_LEN>>();
+  uint32_t i = 0;
+  for (auto _ : state) {
+    HeavyObject obj(i++);
+    queue->tryPush(std::move(obj));
+    auto item = queue->tryPop();
+    benchmark::DoNotOptimize(item->value[0]);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(bmHeavyObjectMove);
+
+/// Construct a HeavyObject in place and read it in place (no copies)
+void bmHeavyObjectInPlace(benchmark::State &state)
+{
+  auto queue = std::make_unique<mpscq<HeavyObject, Q_LEN>>();
+  uint32_t i = 0;
+  for (auto _ : state) {
+    queue->tryEmplace(i++);
+    const auto *item = queue->front();
+    benchmark::DoNotOptimize(item->value[0]);
+    queue->release();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(bmHeavyObjectInPlace);
+
+/// Create a queue, sized at construction if the queue type requires it
+template <typename Queue>
+std::unique_ptr<Queue> makeQueue(size_t capacity)
+{
+  if constexpr (std::is_default_constructible_v<Queue>) {
+    return std::make_unique<Queue>();
+  } else {
+    return std::make_unique<Queue>(capacity);
+  }
+}
+
+/// Push and pop batches of items from a single thread, which isolates the cost of indexing slots
+template <typename Queue>
+void bmCapacityMode(benchmark::State &state)
+{
+  constexpr size_t CAPACITY = 1000;
+  constexpr size_t BATCH = 100;
+  auto queue = makeQueue<Queue>(CAPACITY);
+  for (auto _ : state) {
+    for (size_t i = 0; i < BATCH; ++i) {
+      queue->tryPush(uint64_t{i});
+    }
+    for (size_t i = 0; i < BATCH; ++i) {
+      auto item = queue->tryPop();
+      benchmark::DoNotOptimize(item);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * BATCH));
+}
+
+// compile-time capacity, not a power of two: modulo
+BENCHMARK_TEMPLATE(bmCapacityMode, mpscq<uint64_t, 1000>);
+// compile-time capacity, power of two: mask
+BENCHMARK_TEMPLATE(bmCapacityMode, mpscq<uint64_t, 1024>);
+// runtime capacity (1000, rounded up to 1024 slots): mask
+BENCHMARK_TEMPLATE(bmCapacityMode, mpscq<uint64_t, mpscq_dynamic_capacity>);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -25,8 +25,8 @@ void onSignal(int signum)
 void producer()
 {
   while (!s_exit) {
-    HeavyObject obj(s_value.load());
-    auto pushed = s_queue.tryPush(std::move(obj));
+    // construct in place, no intermediate copy
+    auto pushed = s_queue.tryEmplace(s_value.load());
     std::this_thread::sleep_for(std::chrono::microseconds(1));
     std::this_thread::yield();
     if (pushed) {
@@ -39,14 +39,13 @@ void producer()
 void consumer()
 {
   while (!s_exit) {
-    std::this_thread::yield();
-    std::this_thread::sleep_for(std::chrono::microseconds(1));
-    if (s_queue.count() > 0) {
-      auto t = s_queue.tryPop();
-      if (t.has_value()) {
-        auto val_now = t.value().value[0];
-        std::cout << "consumer - value: " << val_now << "\n";
-      }
+    // block until an item arrives, waking up periodically to check for exit. Read the item in
+    // place and release the slot once done, instead of moving it out
+    const auto *t = s_queue.front(std::chrono::milliseconds(100));
+    if (t != nullptr) {
+      auto val_now = t->value[0];
+      s_queue.release();
+      std::cout << "consumer - value: " << val_now << "\n";
     }
   }
 }
@@ -61,5 +60,12 @@ int main()
   consumer();
   t1.join();
   t2.join();
+#ifdef MPSCQ_STATS
+  const auto stats = s_queue.stats();
+  std::cout << "latency p50: " << stats.latency.percentile(50)
+            << " ns, p99: " << stats.latency.percentile(99) << " ns, max: " << stats.latency.max
+            << " ns, rejected: " << stats.rejected << ", high water mark: " << stats.high_water_mark
+            << "\n";
+#endif
   return 0;
 }
@@ -0,0 +1,224 @@
+#ifndef MULTICAST_RING_H
+#define MULTICAST_RING_H
+
+#include "aligned_buffer.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cinttypes>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <vector>
+
+/// Number of threads allowed to publish to a multicast_ring
+enum class ring_producers
+{
+  single,  ///< Sequences are claimed with a plain increment. Only one thread may push.
+  multiple ///< Sequences are claimed with a compare-and-swap. Any number of threads may push.
+};
+
+/// Bounded ring buffer that delivers every item to every consumer (multicast), in the style of the
+/// LMAX Disruptor.
+/// Items are written once into a preallocated slot and read in place by all consumers, so
+/// subscribers share one copy instead of each having its own queue. Each consumer has its own
+/// cursor (the sequence number of the next item it will read), and a producer may only reuse a slot
+/// once every consumer has moved past it: the slowest consumer gates the producers.
+/// Each slot records the sequence number it was last published for, which tells consumers whether
+/// it is ready for their lap.
+/// \note: capacity_ must be a power of two. The number of consumers is fixed at construction.
+template <typename T, size_t capacity_, ring_producers producers_ = ring_producers::single>
+class multicast_ring
+{
+public:
+  explicit multicast_ring(size_t num_consumers);
+  multicast_ring(const multicast_ring &) = delete;
+  multicast_ring &operator=(const multicast_ring &) = delete;
+
+  bool tryPush(const T &obj);
+  bool tryPush(T &&obj);
+
+  const T *front(size_t consumer) const;
+  void release(size_t consumer);
+  std::optional<T> tryPop(size_t consumer);
+  size_t count(size_t consumer) const;
+  size_t consumers() const;
+  static constexpr size_t capacity() { return capacity_; }
+
+private:
+  static_assert(std::has_single_bit(capacity_), "capacity must be a power of two");
+
+  struct Slot
+  {
+    std::atomic<size_t> published{0}; ///< sequence + 1 of the item in the slot, 0 if none yet
+    T value{};
+  };
+
+  /// Next sequence a consumer will read. One per cache line, so consumers don't contend.
+  struct alignas(cache_line_size) Cursor
+  {
+    std::atomic<size_t> next{0};
+  };
+
+  template <typename U>
+  bool push(U &&obj);
+  size_t claim();
+  bool hasRoom(size_t seq);
+  size_t slowestConsumer() const;
+
+  // read-only after construction (slot contents are owned by whoever the sequences say)
+  std::vector<Slot> slots_;
+  std::vector<Cursor> cursors_;
+
+  // modified by producers
+  alignas(cache_line_size) std::atomic<size_t> head_{0}; ///< next sequence to claim
+  std::atomic<size_t> gate_{0}; ///< last seen position of the slowest consumer
+};
+
+template <typename T, size_t capacity_, ring_producers producers_>
+multicast_ring<T, capacity_, producers_>::multicast_ring(size_t num_consumers)
+  : slots_(capacity_), cursors_(num_consumers)
+{
+  assert(num_consumers >= 1);
+}
+
+/// Attempt to publish a copy of obj to all consumers without blocking.
+/// \note: Only one thread may push with ring_producers::single
+/// \return true on success and false if the slowest consumer is a full ring behind
+template <typename T, size_t capacity_, ring_producers producers_>
+bool multicast_ring<T, capacity_, producers_>::tryPush(const T &obj)
+{
+  return push(obj);
+}
+
+/// Attempt to publish obj to all consumers without blocking.
+/// \note: Only one thread may push with ring_producers::single
+/// \return true on success and false if the slowest consumer is a full ring behind
+template <typename T, size_t capacity_, ring_producers producers_>
+bool multicast_ring<T, capacity_, producers_>::tryPush(T &&obj)
+{
+  return push(std::move(obj));
+}
+
+template <typename T, size_t capacity_, ring_producers producers_>
+template <typename U>
+bool multicast_ring<T, capacity_, producers_>::push(U &&obj)
+{
+  const auto seq = claim();
+  if (seq == std::numeric_limits<size_t>::max()) {
+    return false;
+  }
+  auto &slot = slots_[seq & (capacity_ - 1)];
+  slot.value = std::forward<U>(obj);
+  slot.published.store(seq + 1, std::memory_order_release);
+  return true;
+}
+
+/// Claim the next sequence, if every consumer has moved past the slot it maps to
+/// \return The claimed sequence, or the maximum size_t if the ring is full
+template <typename T, size_t capacity_, ring_producers producers_>
+size_t multicast_ring<T, capacity_, producers_>::claim()
+{
+  auto head = head_.load(std::memory_order_relaxed);
+  if constexpr (producers_ == ring_producers::single) {
+    if (!hasRoom(head)) {
+      return std::numeric_limits<size_t>::max();
+    }
+    head_.store(head + 1, std::memory_order_relaxed);
+    return head;
+  } else {
+    do {
+      if (!hasRoom(head)) {
+        return std::numeric_limits<size_t>::max();
+      }
+    } while (!head_.compare_exchange_weak(head, head + 1, std::memory_order_relaxed));
+    return head;
+  }
+}
+
+/// \return true if the slot for seq has been read by all consumers. Only scans the consumer cursors
+/// when the cached position of the slowest consumer says the ring may be full.
+template <typename T, size_t capacity_, ring_producers producers_>
+bool multicast_ring<T, capacity_, producers_>::hasRoom(size_t seq)
+{
+  // acquire pairs with the release below: the cursors read by whichever producer cached the gate
+  // happen before this producer writes to the slot
+  if (seq < gate_.load(std::memory_order_acquire) + capacity_) {
+    return true;
+  }
+  const auto gate = slowestConsumer();
+  gate_.store(gate, std::memory_order_release);
+  return seq < gate + capacity_;
+}
+
+/// \return The lowest sequence any consumer has yet to read
+template <typename T, size_t capacity_, ring_producers producers_>
+size_t multicast_ring<T, capacity_, producers_>::slowestConsumer() const
+{
+  auto gate = std::numeric_limits<size_t>::max();
+  for (const auto &cursor : cursors_) {
+    // acquire pairs with the release in release(): the consumer is done reading the slot
+    gate = std::min(gate, cursor.next.load(std::memory_order_acquire));
+  }
+  return gate;
+}
+
+/// Access the next item for a consumer in place, without consuming it.
+/// \note: Each consumer index may only be used by one thread
+/// \return Pointer to the item, valid until release(consumer) is called, or nullptr if the consumer
+/// has caught up with the producers
+template <typename T, size_t capacity_, ring_producers producers_>
+const T *multicast_ring<T, capacity_, producers_>::front(size_t consumer) const
+{
+  const auto seq = cursors_[consumer].next.load(std::memory_order_relaxed);
+  const auto &slot = slots_[seq & (capacity_ - 1)];
+  if (slot.published.load(std::memory_order_acquire) != seq + 1) {
+    // not yet published for this lap
+    return nullptr;
+  }
+  return &slot.value;
+}
+
+/// Move a consumer past the item returned by front(consumer). Once all consumers have, producers can
+/// reuse its slot.
+/// \note: Each consumer index may only be used by one thread. Only call after front() returned an
+/// item.
+template <typename T, size_t capacity_, ring_producers producers_>
+void multicast_ring<T, capacity_, producers_>::release(size_t consumer)
+{
+  auto &next = cursors_[consumer].next;
+  next.store(next.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/// Attempt to read a copy of the next item for a consumer without blocking
+/// \note: Each consumer index may only be used by one thread
+/// \return A copy of the item, or nothing if the consumer has caught up with the producers
+template <typename T, size_t capacity_, ring_producers producers_>
+std::optional<T> multicast_ring<T, capacity_, producers_>::tryPop(size_t consumer)
+{
+  const auto *item = front(consumer);
+  if (item == nullptr) {
+    return {};
+  }
+  std::optional<T> ret(*item);
+  release(consumer);
+  return ret;
+}
+
+/// \return The number of items claimed by producers that a consumer has yet to read
+template <typename T, size_t capacity_, ring_producers producers_>
+size_t multicast_ring<T, capacity_, producers_>::count(size_t consumer) const
+{
+  return head_.load(std::memory_order_relaxed) -
+         cursors_[consumer].next.load(std::memory_order_relaxed);
+}
+
+/// \return The number of consumers set at construction
+template <typename T, size_t capacity_, ring_producers producers_>
+size_t multicast_ring<T, capacity_, producers_>::consumers() const
+{
+  return cursors_.size();
+}
+
+#endif // MULTICAST_RING_H
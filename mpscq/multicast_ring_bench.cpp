@@ -0,0 +1,143 @@
+#include "mpscq.h"
+#include "multicast_ring.h"
+#include <benchmark/benchmark.h>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+constexpr size_t Q_LEN = 1024;
+constexpr size_t ITEMS_PER_RUN = 1 << 16;
+
+/// A message every consumer needs, e.g. a sensor frame
+struct Message
+{
+  uint64_t sequence{0};
+  std::array<uint64_t, 31> payload{};
+};
+
+/// Fan-out through one multicast ring read by all consumers
+template <ring_producers producers_>
+class RingFanout
+{
+public:
+  explicit RingFanout(size_t num_consumers) : ring_(num_consumers) {}
+  bool tryPublish(const Message &msg) { return ring_.tryPush(msg); }
+  bool tryConsume(size_t consumer)
+  {
+    const auto *msg = ring_.front(consumer);
+    if (msg == nullptr) {
+      return false;
+    }
+    benchmark::DoNotOptimize(msg->sequence);
+    ring_.release(consumer);
+    return true;
+  }
+
+private:
+  multicast_ring<Message, Q_LEN, producers_> ring_;
+};
+
+/// Fan-out by pushing a copy of every message into one mpscq per consumer
+class QueueFanout
+{
+public:
+  explicit QueueFanout(size_t num_consumers)
+  {
+    for (size_t i = 0; i < num_consumers; ++i) {
+      queues_.push_back(std::make_unique<mpscq<Message, Q_LEN, mpscq_layout::padded>>());
+    }
+  }
+
+  /// Keeps retrying queues that are full, so that every consumer gets the message
+  bool tryPublish(const Message &msg)
+  {
+    for (; next_queue_ < queues_.size(); ++next_queue_) {
+      if (!queues_[next_queue_]->tryEmplace(msg)) {
+        return false;
+      }
+    }
+    next_queue_ = 0;
+    return true;
+  }
+
+  bool tryConsume(size_t consumer)
+  {
+    const auto *msg = queues_[consumer]->front();
+    if (msg == nullptr) {
+      return false;
+    }
+    benchmark::DoNotOptimize(msg->sequence);
+    queues_[consumer]->release();
+    return true;
+  }
+
+private:
+  std::vector<std::unique_ptr<mpscq<Message, Q_LEN, mpscq_layout::padded>>> queues_;
+  size_t next_queue_{0};
+};
+
+/// One producer publishes ITEMS_PER_RUN messages, each of state.range(0) consumers receives all of
+/// them. Times the delivery of every message to every consumer.
+template <typename Fanout>
+void bmFanout(benchmark::State &state)
+{
+  const auto num_consumers = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    auto fanout = std::make_unique<Fanout>(num_consumers);
+    std::vector<std::thread> consumers;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t c = 0; c < num_consumers; ++c) {
+      consumers.emplace_back([&fanout, c] {
+        size_t consumed = 0;
+        while (consumed < ITEMS_PER_RUN) {
+          if (fanout->tryConsume(c)) {
+            ++consumed;
+          } else {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    Message msg;
+    for (size_t i = 0; i < ITEMS_PER_RUN; ++i) {
+      msg.sequence = i;
+      while (!fanout->tryPublish(msg)) {
+        std::this_thread::yield();
+      }
+    }
+    for (auto &t : consumers) {
+      t.join();
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    state.SetIterationTime(elapsed.count());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * ITEMS_PER_RUN));
+}
+
+BENCHMARK_TEMPLATE(bmFanout, RingFanout<ring_producers::single>)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(bmFanout, RingFanout<ring_producers::multiple>)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(bmFanout, QueueFanout)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,169 @@
+#define CATCH_CONFIG_MAIN
+#include "multicast_ring.h"
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+/// Items carry their producer in the high bits and a sequence number in the low bits
+constexpr uint64_t item(uint64_t producer, uint64_t seq)
+{
+  return (producer << 32U) | seq;
+}
+
+/// Consume everything from the ring until num_items have been read, checking that the items of each
+/// producer arrive in the order they were pushed
+/// \return true if all items arrived in order
+template <typename Ring>
+bool consumeInOrder(Ring &ring, size_t consumer, size_t num_producers, uint64_t num_items)
+{
+  std::vector<uint64_t> next(num_producers, 0);
+  bool in_order = true;
+  uint64_t received = 0;
+  while (received < num_items) {
+    if (const auto *value = ring.front(consumer)) {
+      const auto p = *value >> 32U;
+      in_order = in_order && p < num_producers && (*value & 0xffffffffU) == next[p]++;
+      ring.release(consumer);
+      ++received;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  return in_order;
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Empty ring has nothing to pop for any consumer", "[multicast_ring]")
+{
+  multicast_ring<int, 4> ring(2);
+  REQUIRE(ring.consumers() == 2);
+  REQUIRE(ring.front(0) == nullptr);
+  REQUIRE_FALSE(ring.tryPop(1).has_value());
+  REQUIRE(ring.count(0) == 0);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Every consumer reads every item in order", "[multicast_ring]")
+{
+  constexpr size_t NUM_CONSUMERS = 3;
+  multicast_ring<int, 8> ring(NUM_CONSUMERS);
+
+  // several laps of the ring
+  for (int lap = 0; lap < 5; ++lap) {
+    for (int i = 0; i < 8; ++i) {
+      REQUIRE(ring.tryPush(lap * 8 + i));
+    }
+    for (size_t c = 0; c < NUM_CONSUMERS; ++c) {
+      REQUIRE(ring.count(c) == 8);
+      for (int i = 0; i < 8; ++i) {
+        REQUIRE(ring.tryPop(c) == lap * 8 + i);
+      }
+      REQUIRE_FALSE(ring.tryPop(c).has_value());
+    }
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("The slowest consumer gates the producer", "[multicast_ring]")
+{
+  multicast_ring<int, 4> ring(2);
+  for (int i = 0; i < 4; ++i) {
+    REQUIRE(ring.tryPush(int{i}));
+  }
+  REQUIRE_FALSE(ring.tryPush(4));
+
+  // consumer 0 reading everything doesn't make room while consumer 1 hasn't moved
+  for (int i = 0; i < 4; ++i) {
+    REQUIRE(ring.tryPop(0) == i);
+  }
+  REQUIRE_FALSE(ring.tryPush(4));
+
+  // each item consumer 1 reads frees one slot
+  const auto *front = ring.front(1);
+  REQUIRE(front != nullptr);
+  REQUIRE(*front == 0);
+  REQUIRE_FALSE(ring.tryPush(4)); // still being read in place
+  ring.release(1);
+  REQUIRE(ring.tryPush(4));
+  REQUIRE_FALSE(ring.tryPush(5));
+  REQUIRE(ring.count(0) == 1);
+  REQUIRE(ring.count(1) == 4);
+
+  // the overwritten slot holds the new item for consumer 0, and consumer 1 still sees its lap
+  REQUIRE(ring.tryPop(0) == 4);
+  for (int i = 1; i <= 4; ++i) {
+    REQUIRE(ring.tryPop(1) == i);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Consumer threads each receive every item from a producer thread", "[multicast_ring]")
+{
+  constexpr size_t NUM_CONSUMERS = 3;
+  constexpr uint64_t NUM_ITEMS = 200'000;
+  multicast_ring<uint64_t, 64> ring(NUM_CONSUMERS);
+
+  std::vector<std::thread> consumers;
+  std::vector<char> in_order(NUM_CONSUMERS, 0);
+  for (size_t c = 0; c < NUM_CONSUMERS; ++c) {
+    consumers.emplace_back([&ring, &in_order, c] {
+      in_order[c] = consumeInOrder(ring, c, 1, NUM_ITEMS) ? 1 : 0;
+    });
+  }
+  for (uint64_t i = 0; i < NUM_ITEMS; ++i) {
+    while (!ring.tryPush(item(0, i))) {
+      std::this_thread::yield();
+    }
+  }
+  for (auto &thread : consumers) {
+    thread.join();
+  }
+
+  REQUIRE(in_order == std::vector<char>(NUM_CONSUMERS, 1));
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Consumer threads each receive every item from several producer threads",
+          "[multicast_ring]")
+{
+  constexpr size_t NUM_PRODUCERS = 3;
+  constexpr size_t NUM_CONSUMERS = 3;
+  constexpr uint64_t ITEMS_PER_PRODUCER = 50'000;
+  multicast_ring<uint64_t, 64, ring_producers::multiple> ring(NUM_CONSUMERS);
+
+  std::vector<std::thread> consumers;
+  std::vector<char> in_order(NUM_CONSUMERS, 0);
+  for (size_t c = 0; c < NUM_CONSUMERS; ++c) {
+    consumers.emplace_back([&ring, &in_order, c] {
+      in_order[c] =
+          consumeInOrder(ring, c, NUM_PRODUCERS, NUM_PRODUCERS * ITEMS_PER_PRODUCER) ? 1 : 0;
+    });
+  }
+  std::vector<std::thread> producers;
+  for (uint64_t p = 0; p < NUM_PRODUCERS; ++p) {
+    producers.emplace_back([&ring, p] {
+      for (uint64_t i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+        while (!ring.tryPush(item(p, i))) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &thread : producers) {
+    thread.join();
+  }
+  for (auto &thread : consumers) {
+    thread.join();
+  }
+
+  REQUIRE(in_order == std::vector<char>(NUM_CONSUMERS, 1));
+  for (size_t c = 0; c < NUM_CONSUMERS; ++c) {
+    REQUIRE(ring.count(c) == 0);
+  }
+}
+
+} // namespace
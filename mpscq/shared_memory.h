@@ -0,0 +1,145 @@
+#ifndef SHARED_MEMORY_H
+#define SHARED_MEMORY_H
+
+#include <cerrno>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// A named POSIX shared memory segment, mapped read-write into this process.
+/// The owner creates the segment (removing any stale segment of the same name first) and removes
+/// it when done. Other processes open it by name. Same create/open pattern as used by
+/// grape::EgoClock2Driver and grape::EgoClock2.
+class shared_memory
+{
+public:
+  /// Create and map a new segment. Any existing segment with the same name is removed first.
+  /// \param name Segment name (must start with '/')
+  /// \param size Size of the segment in bytes. The memory is zero-initialised.
+  /// \throws std::system_error on failure
+  static shared_memory create(const std::string &name, size_t size);
+
+  /// Map an existing segment
+  /// \param name Segment name (must start with '/')
+  /// \return The mapped segment, or nothing if it doesn't exist (yet)
+  /// \throws std::system_error on failures other than the segment not existing
+  static std::optional<shared_memory> open(const std::string &name);
+
+  /// Remove a segment by name. Processes that have it mapped can continue using it.
+  /// \return true if the segment existed
+  static bool remove(const std::string &name);
+
+  ~shared_memory();
+  shared_memory(shared_memory &&other) noexcept;
+  shared_memory &operator=(shared_memory &&other) noexcept;
+  shared_memory(const shared_memory &) = delete;
+  shared_memory &operator=(const shared_memory &) = delete;
+
+  void *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  shared_memory(void *data, size_t size) : data_(data), size_(size) {}
+  /// \return The mapping, or nullptr with errno set. Leaves fd open
+  static void *map(int fd, size_t size);
+  void *data_{nullptr};
+  size_t size_{0};
+};
+
+inline shared_memory shared_memory::create(const std::string &name, size_t size)
+{
+  (void)remove(name);
+  const auto fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    throw std::system_error(errno, std::system_category(), "shm_open(" + name + ")");
+  }
+  if (ftruncate(fd, static_cast<off_t>(size)) == -1) {
+    const auto err = errno;
+    ::close(fd);
+    (void)remove(name);
+    throw std::system_error(err, std::system_category(), "ftruncate(" + name + ")");
+  }
+  auto *data = map(fd, size);
+  const auto err = errno;
+  ::close(fd);
+  if (data == nullptr) {
+    (void)remove(name);
+    throw std::system_error(err, std::system_category(), "mmap(" + name + ")");
+  }
+  return shared_memory(data, size);
+}
+
+inline std::optional<shared_memory> shared_memory::open(const std::string &name)
+{
+  const auto fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd == -1) {
+    if (errno == ENOENT) {
+      return std::nullopt;
+    }
+    throw std::system_error(errno, std::system_category(), "shm_open(" + name + ")");
+  }
+  struct stat st
+  {
+  };
+  if (fstat(fd, &st) == -1) {
+    const auto err = errno;
+    ::close(fd);
+    throw std::system_error(err, std::system_category(), "fstat(" + name + ")");
+  }
+  if (st.st_size == 0) {
+    // created but not sized yet
+    ::close(fd);
+    return std::nullopt;
+  }
+  const auto size = static_cast<size_t>(st.st_size);
+  auto *data = map(fd, size);
+  const auto err = errno;
+  ::close(fd);
+  if (data == nullptr) {
+    throw std::system_error(err, std::system_category(), "mmap(" + name + ")");
+  }
+  return shared_memory(data, size);
+}
+
+inline bool shared_memory::remove(const std::string &name)
+{
+  return shm_unlink(name.c_str()) == 0;
+}
+
+inline void *shared_memory::map(int fd, size_t size)
+{
+  auto *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  return (data == MAP_FAILED) ? nullptr : data;
+}
+
+inline shared_memory::~shared_memory()
+{
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+inline shared_memory::shared_memory(shared_memory &&other) noexcept
+  : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+{
+}
+
+inline shared_memory &shared_memory::operator=(shared_memory &&other) noexcept
+{
+  if (this != &other) {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+#endif // SHARED_MEMORY_H
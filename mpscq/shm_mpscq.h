@@ -0,0 +1,325 @@
+#ifndef SHM_MPSCQ_H
+#define SHM_MPSCQ_H
+
+#include "aligned_buffer.h"
+#include "shared_memory.h"
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+/// multi-producer, single consumer queue for producers in other processes.
+///
+/// The control block and the slot array live in a POSIX shared memory segment. The consumer creates
+/// the segment and producers open it by name. The segment contains no pointers, only offsets and
+/// lock-free atomics, so it may be mapped at a different address in each process.
+///
+/// Each slot has a single 64-bit state word that packs the queue position the slot is for, the pid
+/// of the producer that claimed it, and whether the item is published. Producers claim a slot
+/// with a CAS on its state before advancing the head, so a slot claimed by a producer that then
+/// dies is always attributable to that producer. The consumer calls recoverAbandoned() to skip
+/// such slots once the owning process no longer exists.
+///
+/// \note Positions are stored truncated to 41 bits in slot states. A producer stalled while 2^41
+/// items pass through the queue could claim a slot for the wrong lap. Process IDs are checked with
+/// kill(pid, 0), so a dead producer whose pid was reused is not detected.
+template <typename T, size_t capacity_>
+class shm_mpscq
+{
+  static_assert(std::is_trivially_copyable_v<T>, "Items are shared across processes");
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "Atomics must work across processes");
+  static_assert(capacity_ >= 1);
+
+public:
+  /// A slot claimed by a producer. See tryClaim()
+  struct Claim
+  {
+    T *value{nullptr};
+    uint64_t position{0};
+    explicit operator bool() const { return value != nullptr; }
+  };
+
+  /// Create the queue (consumer side). Any stale segment with the same name is replaced.
+  /// The segment is removed when the returned queue is destroyed.
+  /// \param name Shared memory name (must start with '/')
+  static shm_mpscq create(const std::string &name);
+
+  /// Open a queue created by the consumer (producer side)
+  /// \param name Shared memory name (must start with '/')
+  /// \return The queue, or nothing if it isn't created yet
+  static std::optional<shm_mpscq> open(const std::string &name);
+
+  ~shm_mpscq();
+  shm_mpscq(shm_mpscq &&other) noexcept;
+  shm_mpscq &operator=(shm_mpscq &&) = delete;
+  shm_mpscq(const shm_mpscq &) = delete;
+  shm_mpscq &operator=(const shm_mpscq &) = delete;
+
+  bool tryPush(const T &obj);
+  Claim tryClaim();
+  void commit(const Claim &claim);
+
+  std::optional<T> tryPop();
+  size_t recoverAbandoned();
+  size_t count() const;
+
+private:
+  static constexpr uint64_t magic_ = 0x6d707363715f7368; // "mpscq_sh"
+  static constexpr unsigned pid_bits_ = 22;              // linux pid_max is at most 2^22
+  static constexpr unsigned position_shift_ = pid_bits_ + 1;
+  static constexpr uint64_t published_bit_ = 1;
+  static constexpr uint64_t pid_mask_ = (uint64_t{1} << pid_bits_) - 1;
+
+  struct Header
+  {
+    std::atomic<uint64_t> magic; ///< set last by the creator, once the segment is initialised
+    uint64_t capacity;
+    uint64_t value_size;
+    alignas(cache_line_size) std::atomic<uint64_t> head; ///< next position to claim
+    alignas(cache_line_size) std::atomic<uint64_t> tail; ///< next position to pop
+  };
+
+  struct alignas(cache_line_size) Slot
+  {
+    std::atomic<uint64_t> state;
+    T value;
+  };
+
+  static constexpr size_t segmentSize() { return sizeof(Header) + capacity_ * sizeof(Slot); }
+  static uint64_t freeState(uint64_t position) { return position << position_shift_; }
+  static uint64_t claimedState(uint64_t position, pid_t pid);
+  static uint64_t positionOf(uint64_t state) { return state >> position_shift_; }
+  static uint64_t truncate(uint64_t position) { return positionOf(freeState(position)); }
+  static pid_t pidOf(uint64_t state) { return static_cast<pid_t>((state >> 1) & pid_mask_); }
+  static bool isAlive(pid_t pid);
+  static pid_t currentPid();
+
+  shm_mpscq(shared_memory &&shm, bool is_owner, const std::string &name);
+  Slot &slot(uint64_t position) { return slots_[position % capacity_]; }
+
+  shared_memory shm_;
+  Header *header_{nullptr};
+  Slot *slots_{nullptr};
+  bool is_owner_{false};
+  std::string name_;
+};
+
+template <typename T, size_t capacity_>
+shm_mpscq<T, capacity_>::shm_mpscq(shared_memory &&shm, bool is_owner, const std::string &name)
+  : shm_(std::move(shm)), is_owner_(is_owner), name_(name)
+{
+  auto *base = static_cast<std::byte *>(shm_.data());
+  header_ = reinterpret_cast<Header *>(base);
+  slots_ = reinterpret_cast<Slot *>(base + sizeof(Header));
+}
+
+template <typename T, size_t capacity_>
+shm_mpscq<T, capacity_> shm_mpscq<T, capacity_>::create(const std::string &name)
+{
+  auto queue = shm_mpscq(shared_memory::create(name, segmentSize()), true, name);
+  auto *header = new (queue.header_) Header{};
+  header->capacity = capacity_;
+  header->value_size = sizeof(T);
+  for (size_t i = 0; i < capacity_; ++i) {
+    auto *slot = new (&queue.slots_[i]) Slot{};
+    slot->state.store(freeState(i), std::memory_order_relaxed);
+  }
+  header->magic.store(magic_, std::memory_order_release);
+  return queue;
+}
+
+template <typename T, size_t capacity_>
+std::optional<shm_mpscq<T, capacity_>> shm_mpscq<T, capacity_>::open(const std::string &name)
+{
+  auto shm = shared_memory::open(name);
+  if (!shm.has_value() || shm->size() < sizeof(Header)) {
+    return std::nullopt;
+  }
+  auto queue = shm_mpscq(std::move(shm.value()), false, name);
+  if (queue.header_->magic.load(std::memory_order_acquire) != magic_) {
+    // not initialised yet
+    return std::nullopt;
+  }
+  if (queue.header_->capacity != capacity_ || queue.header_->value_size != sizeof(T) ||
+      queue.shm_.size() < segmentSize()) {
+    throw std::runtime_error("shm_mpscq: '" + name + "' was created with a different layout");
+  }
+  return queue;
+}
+
+template <typename T, size_t capacity_>
+shm_mpscq<T, capacity_>::~shm_mpscq()
+{
+  if (is_owner_) {
+    (void)shared_memory::remove(name_);
+  }
+}
+
+template <typename T, size_t capacity_>
+shm_mpscq<T, capacity_>::shm_mpscq(shm_mpscq &&other) noexcept
+  : shm_(std::move(other.shm_))
+  , header_(std::exchange(other.header_, nullptr))
+  , slots_(std::exchange(other.slots_, nullptr))
+  , is_owner_(std::exchange(other.is_owner_, false))
+  , name_(std::move(other.name_))
+{
+}
+
+/// Attempt to enqueue without blocking. This is safe to call from multiple threads and processes.
+/// \return true on success and false if queue is full.
+template <typename T, size_t capacity_>
+bool shm_mpscq<T, capacity_>::tryPush(const T &obj)
+{
+  const auto claim = tryClaim();
+  if (!claim) {
+    return false;
+  }
+  *claim.value = obj;
+  commit(claim);
+  return true;
+}
+
+/// Attempt to claim a slot without blocking, for the caller to fill in place. This is safe to call
+/// from multiple threads and processes. A successful claim must be followed by commit(). If this
+/// process dies before committing, the consumer can skip the slot with recoverAbandoned().
+/// \return A valid claim on success, or an empty claim if the queue is full
+template <typename T, size_t capacity_>
+typename shm_mpscq<T, capacity_>::Claim shm_mpscq<T, capacity_>::tryClaim()
+{
+  auto position = header_->head.load(std::memory_order_acquire);
+  while (true) {
+    auto &s = slot(position);
+    auto state = s.state.load(std::memory_order_acquire);
+    if (state == freeState(position)) {
+      // slot is free for this position. Mark it as ours before advancing the head, so that the
+      // claim is attributable to this process even if it dies right after.
+      if (s.state.compare_exchange_weak(state, claimedState(position, currentPid()),
+                                        std::memory_order_acq_rel, std::memory_order_acquire)) {
+        auto expected = position;
+        header_->head.compare_exchange_strong(expected, position + 1, std::memory_order_release,
+                                              std::memory_order_relaxed);
+        return Claim{&s.value, position};
+      }
+    } else if (positionOf(state) == truncate(position)) {
+      // claimed by another producer that hasn't advanced the head yet (or died before it could).
+      // Advance the head on its behalf.
+      auto expected = position;
+      if (header_->head.compare_exchange_strong(expected, position + 1, std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+        ++position;
+      } else {
+        position = expected;
+      }
+    } else if (positionOf(state) == truncate(position - capacity_)) {
+      // slot still holds the item from the previous lap
+      return {};
+    } else {
+      // stale head, another producer got here first
+      position = header_->head.load(std::memory_order_acquire);
+    }
+  }
+}
+
+/// Publish a slot obtained with tryClaim() to the consumer
+template <typename T, size_t capacity_>
+void shm_mpscq<T, capacity_>::commit(const Claim &claim)
+{
+  slot(claim.position)
+      .state.store(claimedState(claim.position, currentPid()) | published_bit_, std::memory_order_release);
+}
+
+/// Attempt to dequeue without blocking
+/// \note: This is not safe to call from multiple threads or processes.
+/// \return A valid item from queue if the operation won't block, else nothing
+template <typename T, size_t capacity_>
+std::optional<T> shm_mpscq<T, capacity_>::tryPop()
+{
+  const auto tail = header_->tail.load(std::memory_order_relaxed);
+  auto &s = slot(tail);
+  const auto state = s.state.load(std::memory_order_acquire);
+  if (positionOf(state) != truncate(tail) || (state & published_bit_) == 0) {
+    // empty, or a producer is still writing to this location
+    return {};
+  }
+  std::optional<T> ret(s.value);
+  s.state.store(freeState(tail + capacity_), std::memory_order_release);
+  header_->tail.store(tail + 1, std::memory_order_release);
+  return ret;
+}
+
+/// Skip slots at the front of the queue that were claimed by producer processes which exited
+/// before publishing them. Call this when tryPop() has been failing while count() is non-zero.
+/// This makes a system call per claimed slot inspected, so don't call it on every pop.
+/// \note: This is not safe to call from multiple threads or processes.
+/// \return Number of slots skipped
+template <typename T, size_t capacity_>
+size_t shm_mpscq<T, capacity_>::recoverAbandoned()
+{
+  size_t num = 0;
+  while (true) {
+    const auto tail = header_->tail.load(std::memory_order_relaxed);
+    auto &s = slot(tail);
+    auto state = s.state.load(std::memory_order_acquire);
+    const auto is_claimed = (positionOf(state) == truncate(tail)) &&
+                            ((state & published_bit_) == 0) && (pidOf(state) != 0);
+    if (!is_claimed || isAlive(pidOf(state))) {
+      return num;
+    }
+
+    // the owner is gone and can't publish anymore. Release the slot for the next lap, and advance
+    // the head past it in case the owner died before doing so.
+    if (!s.state.compare_exchange_strong(state, freeState(tail + capacity_),
+                                         std::memory_order_acq_rel)) {
+      return num;
+    }
+    auto expected = tail;
+    header_->head.compare_exchange_strong(expected, tail + 1, std::memory_order_acq_rel,
+                                          std::memory_order_relaxed);
+    header_->tail.store(tail + 1, std::memory_order_release);
+    ++num;
+  }
+}
+
+/// \return The number of claimed slots, published or not
+template <typename T, size_t capacity_>
+size_t shm_mpscq<T, capacity_>::count() const
+{
+  const auto tail = header_->tail.load(std::memory_order_relaxed);
+  const auto head = header_->head.load(std::memory_order_relaxed);
+  return (head > tail) ? (head - tail) : 0;
+}
+
+template <typename T, size_t capacity_>
+uint64_t shm_mpscq<T, capacity_>::claimedState(uint64_t position, pid_t pid)
+{
+  return freeState(position) | ((static_cast<uint64_t>(pid) & pid_mask_) << 1);
+}
+
+template <typename T, size_t capacity_>
+bool shm_mpscq<T, capacity_>::isAlive(pid_t pid)
+{
+  return (kill(pid, 0) == 0) || (errno != ESRCH);
+}
+
+/// \return pid of the calling process, so that a queue opened before fork() tags the claims of the
+/// child with the child's pid. Cached rather than a system call per claim, and refreshed in the
+/// child by a fork handler
+template <typename T, size_t capacity_>
+pid_t shm_mpscq<T, capacity_>::currentPid()
+{
+  static pid_t pid = [] {
+    pthread_atfork(nullptr, nullptr, [] { pid = getpid(); });
+    return getpid();
+  }();
+  return pid;
+}
+
+#endif // SHM_MPSCQ_H
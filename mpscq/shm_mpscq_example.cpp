@@ -0,0 +1,87 @@
+#include "shm_mpscq.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct Message
+{
+  pid_t sender;
+  uint32_t value;
+};
+
+constexpr size_t Q_LEN = 64;
+constexpr uint32_t NUM_PRODUCERS = 3;
+constexpr uint32_t ITEMS_PER_PRODUCER = 10000;
+constexpr auto QUEUE_NAME = "/mpscq_example";
+using Queue = shm_mpscq<Message, Q_LEN>;
+
+/// Runs in a child process: push ITEMS_PER_PRODUCER messages
+void producer()
+{
+  auto queue = Queue::open(QUEUE_NAME);
+  if (!queue) {
+    std::cerr << "Queue not found\n";
+    _exit(EXIT_FAILURE);
+  }
+  for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+    while (!queue->tryPush(Message{getpid(), i})) {
+      std::this_thread::yield();
+    }
+  }
+  _exit(EXIT_SUCCESS);
+}
+
+/// Runs in a child process: claim a slot and die without publishing it
+void crashingProducer()
+{
+  auto queue = Queue::open(QUEUE_NAME);
+  if (queue && queue->tryClaim()) {
+    std::cout << "Producer " << getpid() << " claimed a slot and exits without committing"
+              << std::endl;
+  }
+  _exit(EXIT_FAILURE);
+}
+
+int main()
+{
+  // consumer owns the queue
+  auto queue = Queue::create(QUEUE_NAME);
+
+  std::vector<pid_t> children;
+  const auto spawn = [&children](void (*fn)()) {
+    const auto pid = fork();
+    if (pid == 0) {
+      fn();
+    }
+    children.push_back(pid);
+  };
+
+  // the crashing producer goes first, so the consumer is stuck behind its slot until it recovers
+  spawn(crashingProducer);
+  waitpid(children.back(), nullptr, 0); // reap it, else it lingers as a zombie and looks alive
+  for (uint32_t i = 0; i < NUM_PRODUCERS; ++i) {
+    spawn(producer);
+  }
+
+  size_t received = 0;
+  size_t recovered = 0;
+  while (received < NUM_PRODUCERS * ITEMS_PER_PRODUCER) {
+    if (queue.tryPop().has_value()) {
+      ++received;
+    } else {
+      recovered += queue.recoverAbandoned();
+      std::this_thread::sleep_for(std::chrono::microseconds(10));
+    }
+  }
+  for (size_t i = 1; i < children.size(); ++i) {
+    waitpid(children[i], nullptr, 0);
+  }
+
+  std::cout << "Received " << received << " messages, recovered " << recovered
+            << " abandoned slot(s)\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,210 @@
+#define CATCH_CONFIG_MAIN
+#include "shm_mpscq.h"
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+struct Message
+{
+  pid_t sender;
+  uint32_t value;
+};
+
+/// Segment name unique to this test process, so concurrent test runs don't collide
+std::string queueName(const std::string &test)
+{
+  return "/shm_mpscq_test_" + test + "_" + std::to_string(getpid());
+}
+
+/// Run fn in a child process, which exits with status 0 if fn returns true
+pid_t spawn(const std::function<bool()> &fn)
+{
+  const auto pid = fork();
+  if (pid == 0) {
+    _exit(fn() ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+  return pid;
+}
+
+/// Wait for a child process, so that it doesn't linger as a zombie
+/// \return true if it exited with status 0
+bool reap(pid_t pid)
+{
+  int status = 0;
+  return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Producers can only open a queue once it is created", "[shm_mpscq]")
+{
+  const auto name = queueName("open");
+  REQUIRE_FALSE(shm_mpscq<Message, 4>::open(name).has_value());
+  {
+    auto queue = shm_mpscq<Message, 4>::create(name);
+    REQUIRE(shm_mpscq<Message, 4>::open(name).has_value());
+    REQUIRE_THROWS_AS((shm_mpscq<Message, 8>::open(name)), std::runtime_error);
+    REQUIRE_THROWS_AS((shm_mpscq<uint32_t, 4>::open(name)), std::runtime_error);
+  }
+  // removed by the consumer
+  REQUIRE_FALSE(shm_mpscq<Message, 4>::open(name).has_value());
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Items are popped in the order they were pushed, until the queue is full", "[shm_mpscq]")
+{
+  constexpr uint32_t N = 3; // not a power of two
+  const auto name = queueName("order");
+  auto consumer = shm_mpscq<Message, N>::create(name);
+  auto producer = shm_mpscq<Message, N>::open(name);
+  REQUIRE(producer.has_value());
+  REQUIRE_FALSE(consumer.tryPop().has_value());
+
+  // several laps of the ring
+  uint32_t next_push = 0;
+  uint32_t next_pop = 0;
+  for (int lap = 0; lap < 5; ++lap) {
+    while (producer->tryPush(Message{getpid(), next_push})) {
+      ++next_push;
+    }
+    REQUIRE(consumer.count() == N);
+    REQUIRE(consumer.tryPop()->value == next_pop++);
+    REQUIRE(producer->tryPush(Message{getpid(), next_push++}));
+    REQUIRE_FALSE(producer->tryPush(Message{getpid(), 0}));
+    while (auto item = consumer.tryPop()) {
+      REQUIRE(item->value == next_pop++);
+    }
+    REQUIRE(consumer.count() == 0);
+  }
+  REQUIRE(next_pop == next_push);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Producer processes transfer every item in order", "[shm_mpscq]")
+{
+  constexpr uint32_t NUM_PRODUCERS = 3;
+  constexpr uint32_t ITEMS_PER_PRODUCER = 20'000;
+  using Queue = shm_mpscq<Message, 64>;
+  const auto name = queueName("stress");
+  auto queue = Queue::create(name);
+
+  std::vector<pid_t> producers;
+  for (uint32_t p = 0; p < NUM_PRODUCERS; ++p) {
+    producers.push_back(spawn([&name] {
+      auto producer = Queue::open(name);
+      if (!producer) {
+        return false;
+      }
+      for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+        while (!producer->tryPush(Message{getpid(), i})) {
+          std::this_thread::yield();
+        }
+      }
+      return true;
+    }));
+  }
+
+  // the items of each producer arrive in the order they were pushed
+  std::vector<uint32_t> next(NUM_PRODUCERS, 0);
+  bool in_order = true;
+  uint32_t received = 0;
+  while (received < NUM_PRODUCERS * ITEMS_PER_PRODUCER) {
+    if (auto item = queue.tryPop()) {
+      const auto p = static_cast<size_t>(
+          std::find(producers.begin(), producers.end(), item->sender) - producers.begin());
+      in_order = in_order && p < NUM_PRODUCERS && item->value == next[p]++;
+      ++received;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (const auto pid : producers) {
+    REQUIRE(reap(pid));
+  }
+
+  REQUIRE(in_order);
+  REQUIRE(next == std::vector<uint32_t>(NUM_PRODUCERS, ITEMS_PER_PRODUCER));
+  REQUIRE_FALSE(queue.tryPop().has_value());
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Slots claimed by producers that died are recovered", "[shm_mpscq]")
+{
+  using Queue = shm_mpscq<Message, 4>;
+  const auto name = queueName("recover");
+  auto queue = Queue::create(name);
+  auto producer = Queue::open(name);
+  REQUIRE(producer.has_value());
+
+  // a producer claims a slot and exits without committing it
+  REQUIRE(reap(spawn([&name] {
+    auto crashing = Queue::open(name);
+    return crashing && crashing->tryClaim();
+  })));
+  REQUIRE(producer->tryPush(Message{getpid(), 1}));
+
+  // the consumer is stuck behind the abandoned slot until it recovers it
+  REQUIRE(queue.count() == 2);
+  REQUIRE_FALSE(queue.tryPop().has_value());
+  REQUIRE(queue.recoverAbandoned() == 1);
+  REQUIRE(queue.tryPop()->value == 1);
+  REQUIRE(queue.count() == 0);
+
+  // the slot is reused on the next lap
+  for (uint32_t i = 0; i < 4; ++i) {
+    REQUIRE(producer->tryPush(Message{getpid(), i}));
+  }
+  for (uint32_t i = 0; i < 4; ++i) {
+    REQUIRE(queue.tryPop()->value == i);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Slots claimed by a child through a queue opened before fork() are recovered",
+          "[shm_mpscq]")
+{
+  using Queue = shm_mpscq<Message, 4>;
+  const auto name = queueName("forked");
+  auto queue = Queue::create(name);
+  auto producer = Queue::open(name);
+  REQUIRE(producer.has_value());
+  REQUIRE(producer->tryPush(Message{getpid(), 1}));
+
+  // the child inherits the open queue, and claims under its own pid
+  REQUIRE(reap(spawn([&producer] { return static_cast<bool>(producer->tryClaim()); })));
+  REQUIRE(producer->tryPush(Message{getpid(), 2}));
+
+  REQUIRE(queue.tryPop()->value == 1);
+  REQUIRE_FALSE(queue.tryPop().has_value());
+  REQUIRE(queue.recoverAbandoned() == 1);
+  REQUIRE(queue.tryPop()->value == 2);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Slots claimed by live producers are not recovered", "[shm_mpscq]")
+{
+  using Queue = shm_mpscq<Message, 4>;
+  const auto name = queueName("live");
+  auto queue = Queue::create(name);
+  auto producer = Queue::open(name);
+  REQUIRE(producer.has_value());
+
+  const auto claim = producer->tryClaim();
+  REQUIRE(claim);
+  REQUIRE(queue.recoverAbandoned() == 0);
+  REQUIRE_FALSE(queue.tryPop().has_value());
+
+  *claim.value = Message{getpid(), 7};
+  producer->commit(claim);
+  REQUIRE(queue.tryPop()->value == 7);
+}
+
+} // namespace
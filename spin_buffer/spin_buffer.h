@@ -0,0 +1,125 @@
+#ifndef SPIN_BUFFER_H
+#define SPIN_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+/// Single-producer, single-consumer queue made of three buffers of N items each.
+///
+/// The producer fills one buffer and the consumer drains another, with no synchronisation per
+/// element. The third buffer is free. Both sides move round the ring in the same direction, so
+/// only one of them can have the free buffer as its next buffer at any time. That lets a side
+/// take the free buffer with a plain store to its busy flag, without a read-modify-write.
+/// - The producer hands over its buffer when the next buffer is free, after every push.
+/// - The consumer moves to the next buffer when it has drained its own and the next one is free.
+///
+/// Items pushed while the consumer still holds the next buffer stay with the producer until a
+/// later push or flush() hands them over.
+///
+/// Based on Prashanth Hirematada, "Spin Buffers", Dr. Dobb's Journal, 2007.
+template <typename T, size_t N>
+class SpinBuffer
+{
+public:
+  SpinBuffer();
+  SpinBuffer(const SpinBuffer &) = delete;
+  SpinBuffer &operator=(const SpinBuffer &) = delete;
+
+  bool tryPush(T &&obj);
+  bool flush();
+  std::optional<T> tryPop();
+
+private:
+  static constexpr size_t NUM_BUFFERS = 3;
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+  static constexpr size_t next(size_t buffer) { return (buffer + 1) % NUM_BUFFERS; }
+  T &item(size_t buffer, size_t index) { return items_[(buffer * N) + index]; }
+
+  // read-only after construction (the items themselves are owned by one side at a time)
+  std::vector<T> items_;
+
+  // count_[i] is written by whichever side owns buffer i, published via busy_[i]
+  std::array<size_t, NUM_BUFFERS> count_{};
+  std::array<std::atomic<bool>, NUM_BUFFERS> busy_{};
+
+  // producer only
+  alignas(CACHE_LINE_SIZE) size_t write_buffer_{0};
+  size_t write_index_{0};
+
+  // consumer only
+  alignas(CACHE_LINE_SIZE) size_t read_buffer_{1};
+  size_t read_index_{0};
+};
+
+template <typename T, size_t N>
+SpinBuffer<T, N>::SpinBuffer() : items_(NUM_BUFFERS * N)
+{
+  static_assert(N >= 1);
+  busy_[write_buffer_].store(true, std::memory_order_relaxed);
+  busy_[read_buffer_].store(true, std::memory_order_relaxed);
+}
+
+/// Attempt to enqueue without blocking
+/// \note: Only one thread may push
+/// \return true on success, false if the producer's buffer is full and can't be handed over yet
+template <typename T, size_t N>
+bool SpinBuffer<T, N>::tryPush(T &&obj)
+{
+  if (write_index_ == N && !flush()) {
+    return false;
+  }
+  item(write_buffer_, write_index_++) = std::move(obj);
+  (void)flush();
+  return true;
+}
+
+/// Hand items pushed so far over to the consumer, if the next buffer is free.
+/// Call this at the end of a burst, so that items don't wait for the next push.
+/// \note: Only the producer thread may call this
+/// \return true if no items are left with the producer
+template <typename T, size_t N>
+bool SpinBuffer<T, N>::flush()
+{
+  if (write_index_ == 0) {
+    return true;
+  }
+  const auto next_buffer = next(write_buffer_);
+  if (busy_[next_buffer].load(std::memory_order_acquire)) {
+    return false;
+  }
+  count_[write_buffer_] = write_index_;
+  write_index_ = 0;
+  busy_[next_buffer].store(true, std::memory_order_relaxed);
+  busy_[write_buffer_].store(false, std::memory_order_release);
+  write_buffer_ = next_buffer;
+  return true;
+}
+
+/// Attempt to dequeue without blocking
+/// \note: Only one thread may pop
+/// \return A valid item if one was handed over by the producer, else nothing
+template <typename T, size_t N>
+std::optional<T> SpinBuffer<T, N>::tryPop()
+{
+  if (read_index_ == count_[read_buffer_]) {
+    // drained; move on to the next buffer if the producer has released it
+    const auto next_buffer = next(read_buffer_);
+    if (busy_[next_buffer].load(std::memory_order_acquire)) {
+      return {};
+    }
+    count_[read_buffer_] = 0;
+    read_index_ = 0;
+    busy_[next_buffer].store(true, std::memory_order_relaxed);
+    busy_[read_buffer_].store(false, std::memory_order_release);
+    read_buffer_ = next_buffer;
+    if (count_[read_buffer_] == 0) {
+      return {};
+    }
+  }
+  return std::move(item(read_buffer_, read_index_++));
+}
+
+#endif // SPIN_BUFFER_H
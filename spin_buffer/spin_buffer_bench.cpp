@@ -0,0 +1,127 @@
+#include "mpscq.h"
+#include "spin_buffer.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+constexpr size_t Q_LEN = 4096;
+constexpr size_t ITEMS_PER_RUN = 1 << 18;
+constexpr auto BURST_PAUSE = std::chrono::microseconds(20);
+
+/// Ring buffer with a mutex around every access (Listing One of the Spin Buffers article)
+template <typename T, size_t N>
+class LockedRingBuffer
+{
+public:
+  LockedRingBuffer() : items_(N) {}
+
+  bool tryPush(T &&obj)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size_ == N) {
+      return false;
+    }
+    items_[write_index_] = std::move(obj);
+    write_index_ = (write_index_ + 1) % N;
+    ++size_;
+    return true;
+  }
+
+  std::optional<T> tryPop()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size_ == 0) {
+      return {};
+    }
+    auto ret = std::move(items_[read_index_]);
+    read_index_ = (read_index_ + 1) % N;
+    --size_;
+    return ret;
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<T> items_;
+  size_t write_index_{0};
+  size_t read_index_{0};
+  size_t size_{0};
+};
+
+/// End of burst: hand over items still held by the producer, for queues that hold any back
+template <typename Queue>
+void flush(Queue &queue)
+{
+  if constexpr (requires { queue.flush(); }) {
+    while (!queue.flush()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+/// One producer pushes ITEMS_PER_RUN items in bursts of state.range(0) items, pausing between
+/// bursts. One consumer pops continuously. Times the transfer of all items.
+template <typename Queue>
+void bmBurstyProducer(benchmark::State &state)
+{
+  const auto burst_size = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    auto queue = std::make_unique<Queue>();
+
+    const auto start = std::chrono::steady_clock::now();
+    auto producer = std::thread([&queue, burst_size] {
+      size_t pushed = 0;
+      while (pushed < ITEMS_PER_RUN) {
+        for (size_t i = 0; i < burst_size && pushed < ITEMS_PER_RUN; ++i, ++pushed) {
+          while (!queue->tryPush(uint64_t{pushed})) {
+            std::this_thread::yield();
+          }
+        }
+        flush(*queue);
+        std::this_thread::sleep_for(BURST_PAUSE);
+      }
+    });
+    size_t consumed = 0;
+    while (consumed < ITEMS_PER_RUN) {
+      auto item = queue->tryPop();
+      if (item.has_value()) {
+        benchmark::DoNotOptimize(item);
+        ++consumed;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    producer.join();
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    state.SetIterationTime(elapsed.count());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * ITEMS_PER_RUN));
+}
+
+BENCHMARK_TEMPLATE(bmBurstyProducer, SpinBuffer<uint64_t, Q_LEN>)
+    ->RangeMultiplier(16)
+    ->Range(16, 4096)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(bmBurstyProducer, mpscq<uint64_t, Q_LEN, mpscq_layout::padded>)
+    ->RangeMultiplier(16)
+    ->Range(16, 4096)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(bmBurstyProducer, LockedRingBuffer<uint64_t, Q_LEN>)
+    ->RangeMultiplier(16)
+    ->Range(16, 4096)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
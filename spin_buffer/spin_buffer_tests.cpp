@@ -0,0 +1,131 @@
+#define CATCH_CONFIG_MAIN
+#include "spin_buffer.h"
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+/// Pop until max items are received or no progress is made for a while
+template <typename Buffer, typename T>
+void drain(Buffer &buffer, std::vector<T> &out, size_t max)
+{
+  constexpr size_t MAX_MISSES = 10;
+  size_t misses = 0;
+  while (out.size() < max && misses < MAX_MISSES) {
+    auto item = buffer.tryPop();
+    if (item.has_value()) {
+      out.push_back(std::move(item.value()));
+      misses = 0;
+    } else {
+      ++misses;
+    }
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Empty buffer has nothing to pop", "[spin_buffer]")
+{
+  SpinBuffer<int, 4> buffer;
+  REQUIRE_FALSE(buffer.tryPop().has_value());
+  REQUIRE(buffer.flush());
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Items are popped in the order they were pushed", "[spin_buffer]")
+{
+  SpinBuffer<int, 4> buffer;
+  std::vector<int> out;
+  for (int i = 0; i < 100; ++i) {
+    // a single thread alternates roles, so the producer only gets a free buffer once the
+    // consumer has moved
+    while (!buffer.tryPush(int{i})) {
+      drain(buffer, out, 100);
+    }
+  }
+  while (!buffer.flush()) {
+    drain(buffer, out, 100);
+  }
+  drain(buffer, out, 100);
+
+  REQUIRE(out.size() == 100);
+  for (int i = 0; i < 100; ++i) {
+    REQUIRE(out[static_cast<size_t>(i)] == i);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Push fails when the producer buffer is full and can't be handed over", "[spin_buffer]")
+{
+  constexpr size_t N = 4;
+  SpinBuffer<int, N> buffer;
+
+  // consumer holds the next buffer, so nothing can be handed over
+  for (size_t i = 0; i < N; ++i) {
+    REQUIRE(buffer.tryPush(static_cast<int>(i)));
+  }
+  REQUIRE_FALSE(buffer.tryPush(99));
+  REQUIRE_FALSE(buffer.flush());
+
+  // consumer moves on, which frees a buffer for the producer
+  REQUIRE_FALSE(buffer.tryPop().has_value());
+  REQUIRE(buffer.flush());
+  REQUIRE(buffer.tryPush(static_cast<int>(N)));
+
+  std::vector<int> out;
+  drain(buffer, out, N);
+  REQUIRE(out == std::vector<int>{0, 1, 2, 3});
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Items that aren't trivially copyable are moved through", "[spin_buffer]")
+{
+  SpinBuffer<std::string, 2> buffer;
+  const auto long_string = std::string(100, 'x');
+  REQUIRE_FALSE(buffer.tryPop().has_value()); // consumer moves, next buffer becomes free
+  REQUIRE(buffer.tryPush(std::string(long_string)));
+
+  std::vector<std::string> out;
+  drain(buffer, out, 1);
+  REQUIRE(out.size() == 1);
+  REQUIRE(out.front() == long_string);
+}
+
+//-------------------------------------------------------------------------------------------------
+TEST_CASE("Producer and consumer threads transfer all items in order", "[spin_buffer]")
+{
+  constexpr uint64_t NUM_ITEMS = 1'000'000;
+  SpinBuffer<uint64_t, 256> buffer;
+
+  auto producer = std::thread([&buffer] {
+    for (uint64_t i = 0; i < NUM_ITEMS; ++i) {
+      while (!buffer.tryPush(uint64_t{i})) {
+        std::this_thread::yield();
+      }
+    }
+    while (!buffer.flush()) {
+      std::this_thread::yield();
+    }
+  });
+
+  uint64_t expected = 0;
+  bool in_order = true;
+  while (expected < NUM_ITEMS) {
+    auto item = buffer.tryPop();
+    if (item.has_value()) {
+      in_order = in_order && (item.value() == expected);
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  REQUIRE(in_order);
+  REQUIRE_FALSE(buffer.tryPop().has_value());
+}
+
+} // namespace